@@ -0,0 +1,111 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+// 单调 arena：只做指针递增分配，deallocate 什么也不做，
+// 全部内存在 release() 或析构时按块一次性归还，与分配过多少个对象无关。
+// 适合请求级的临时对象：配合 arena_allocator 传给 allocate_shared，
+// 请求结束时整块丢弃。arena 必须比从它分配的所有 SharedPtr/WeakPtr 活得更久，
+// 对象的析构函数仍然在最后一个 SharedPtr 离开时照常执行。
+// 不是线程安全的，一个 arena 只能由一个线程分配。
+class monotonic_arena {
+public:
+  explicit monotonic_arena(std::size_t initial_chunk_size = 4096) noexcept
+      : next_chunk_size(initial_chunk_size ? initial_chunk_size : 64) {}
+  // 先用调用方提供的缓冲区 (例如栈上数组)，用完后再向堆申请
+  monotonic_arena(void *buffer, std::size_t size) noexcept
+      : cursor(static_cast<char *>(buffer)),
+        end(static_cast<char *>(buffer) + size), initial_buffer(cursor),
+        initial_end(end), next_chunk_size(size ? size : 64) {}
+  monotonic_arena(const monotonic_arena &) = delete;
+  monotonic_arena &operator=(const monotonic_arena &) = delete;
+  ~monotonic_arena() { release(); }
+
+  void *allocate(std::size_t bytes, std::size_t align) {
+    std::uintptr_t address = align_up(reinterpret_cast<std::uintptr_t>(cursor),
+                                      align);
+    if (!cursor || address + bytes > reinterpret_cast<std::uintptr_t>(end)) {
+      grow(bytes + align);
+      address = align_up(reinterpret_cast<std::uintptr_t>(cursor), align);
+    }
+    cursor = reinterpret_cast<char *>(address + bytes);
+    used += bytes;
+    return reinterpret_cast<void *>(address);
+  }
+  void deallocate(void *, std::size_t) noexcept {}
+
+  // 归还所有向堆申请的块，之后从调用方提供的缓冲区 (若有) 重新开始
+  void release() noexcept {
+    while (chunks) {
+      chunk *next = chunks->next;
+      ::operator delete(chunks);
+      chunks = next;
+    }
+    cursor = initial_buffer;
+    end = initial_end;
+    used = 0;
+  }
+  std::size_t bytes_allocated() const noexcept { return used; }
+
+private:
+  struct alignas(std::max_align_t) chunk {
+    chunk *next;
+  };
+
+  static std::uintptr_t align_up(std::uintptr_t address,
+                                 std::size_t align) noexcept {
+    return (address + align - 1) & ~static_cast<std::uintptr_t>(align - 1);
+  }
+  // 块大小按 2 倍增长，块数只随总用量对数增长
+  void grow(std::size_t min_bytes) {
+    std::size_t size = next_chunk_size;
+    while (size < min_bytes) {
+      size *= 2;
+    }
+    void *memory = ::operator new(sizeof(chunk) + size);
+    chunks = ::new (memory) chunk{chunks};
+    cursor = reinterpret_cast<char *>(chunks + 1);
+    end = cursor + size;
+    next_chunk_size = size * 2;
+  }
+
+  char *cursor = nullptr;
+  char *end = nullptr;
+  char *initial_buffer = nullptr;
+  char *initial_end = nullptr;
+  chunk *chunks = nullptr;
+  std::size_t next_chunk_size;
+  std::size_t used = 0;
+};
+
+// 把 monotonic_arena 包装成标准分配器，只保存一个指向 arena 的指针
+template <typename T> class arena_allocator {
+public:
+  using value_type = T;
+
+  explicit arena_allocator(monotonic_arena &a) noexcept : arena(&a) {}
+  template <typename U>
+  arena_allocator(const arena_allocator<U> &other) noexcept
+      : arena(other.arena) {}
+
+  T *allocate(std::size_t n) {
+    return static_cast<T *>(arena->allocate(n * sizeof(T), alignof(T)));
+  }
+  void deallocate(T *p, std::size_t n) noexcept {
+    arena->deallocate(p, n * sizeof(T));
+  }
+
+  template <typename U>
+  bool operator==(const arena_allocator<U> &other) const noexcept {
+    return arena == other.arena;
+  }
+  template <typename U>
+  bool operator!=(const arena_allocator<U> &other) const noexcept {
+    return arena != other.arena;
+  }
+
+private:
+  template <typename> friend class arena_allocator;
+  monotonic_arena *arena;
+};
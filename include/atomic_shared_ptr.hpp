@@ -0,0 +1,177 @@
+#pragma once
+#include "control_.hpp"
+#include <cstdint>
+
+// 可以被多个线程同时 load/store 的 SharedPtr，读者既不加锁也不会被写者阻塞。
+//
+// 实现为分离引用计数 (split reference count)：
+// - 每次 store 把 SharedPtr 包进一个快照块 snapshot，它本身也是一个控制块，
+//   AtomicSharedPtr 持有它的 bias 个强引用。
+// - 原子字的低 48 位是快照块指针，高 16 位是本地计数，即正在读这个快照的读者数。
+//   读者先 fetch_add 本地计数把快照钉住，从中拷贝出 SharedPtr，再把本地计数减回去。
+// - 写者换下快照时把换下来的本地计数 k 转成快照块上的强引用：
+//   一次性减去 bias - k。仍在读旧快照的读者发现指针已变，改为释放一个强引用。
+//   bias 大于本地计数的上限，所以不论读者和写者谁先到，快照块都不会被提前释放。
+// 读者钉住期间快照块不会被释放，地址也就不会被复用，不存在 ABA 问题。
+// 存入的指针可以用任意 Policy 计数，快照块自身总是原子计数。存入前先调用
+// 控制块的 share_across_threads，hybrid_policy 的指针在这里升级为原子计数。
+// 限制：需要 48 位用户态地址 (x86-64 / AArch64)，同时钉住同一快照的读者少于 65536 个。
+template <typename T, typename Policy = atomic_policy> class AtomicSharedPtr {
+  static_assert(!is_single_thread_policy<Policy>::value,
+                "AtomicSharedPtr needs counts that can cross threads; use "
+                "atomic_policy or hybrid_policy instead of local_policy");
+
+public:
+  using value_type = SharedPtr<T, Policy>;
+
+  AtomicSharedPtr() noexcept : word(0) {}
+  AtomicSharedPtr(value_type desired)
+      : word(pack(make_snapshot(std::move(desired)))) {}
+  AtomicSharedPtr(const AtomicSharedPtr &) = delete;
+  AtomicSharedPtr &operator=(const AtomicSharedPtr &) = delete;
+  ~AtomicSharedPtr() {
+    std::uint64_t w = word.load(std::memory_order_acquire);
+    retire(unpack(w), pins(w));
+  }
+
+  static constexpr bool is_always_lock_free = true;
+  bool is_lock_free() const noexcept { return true; }
+
+  value_type load() const {
+    snapshot *s = pin();
+    value_type result = s ? value_type(s->value) : value_type();
+    unpin(s);
+    return result;
+  }
+  operator value_type() const { return load(); }
+
+  void store(value_type desired) { exchange(std::move(desired)); }
+  AtomicSharedPtr &operator=(value_type desired) {
+    store(std::move(desired));
+    return *this;
+  }
+
+  value_type exchange(value_type desired) {
+    std::uint64_t w = word.exchange(pack(make_snapshot(std::move(desired))),
+                                    std::memory_order_acq_rel);
+    snapshot *old = unpack(w);
+    // 换下来的快照还持有 bias 个引用，拷贝之后再交还
+    value_type result = old ? value_type(old->value) : value_type();
+    retire(old, pins(w));
+    return result;
+  }
+
+  // 当前值与 expected 指向同一对象且共享同一控制块时换成 desired；
+  // 否则把当前值写回 expected 并返回 false
+  bool compare_exchange_strong(value_type &expected, value_type desired) {
+    snapshot *replacement = nullptr;
+    bool built = false;
+    for (;;) {
+      snapshot *current = pin();
+      if (!holds(current, expected)) {
+        expected = current ? value_type(current->value) : value_type();
+        unpin(current);
+        if (built) {
+          retire(replacement, 0);
+        }
+        return false;
+      }
+      if (!built) {
+        replacement = make_snapshot(std::move(desired));
+        built = true;
+      }
+      std::uint64_t w = word.load(std::memory_order_relaxed);
+      while (unpack(w) == current) {
+        if (word.compare_exchange_weak(w, pack(replacement),
+                                       std::memory_order_acq_rel,
+                                       std::memory_order_relaxed)) {
+          // 本地计数里包含我们自己的那一次钉住，它不需要转成引用
+          retire(current, pins(w) - 1);
+          return true;
+        }
+      }
+      // 指针已被别的写者换掉，我们的钉住计数已转成一个强引用
+      release_one(current);
+    }
+  }
+  // 本实现不会伪失败，weak 与 strong 相同
+  bool compare_exchange_weak(value_type &expected, value_type desired) {
+    return compare_exchange_strong(expected, std::move(desired));
+  }
+
+private:
+  static constexpr int pointer_bits = 48;
+  static constexpr std::uint64_t pointer_mask =
+      (std::uint64_t(1) << pointer_bits) - 1;
+  static constexpr std::uint64_t one_pin = std::uint64_t(1) << pointer_bits;
+  static constexpr int bias = 1 << (64 - pointer_bits);
+  static_assert(sizeof(void *) == 8, "AtomicSharedPtr needs 64-bit pointers");
+
+  struct snapshot : control_block_base {
+    value_type value;
+    explicit snapshot(value_type v)
+        : control_block_base(bias, 1), value(std::move(v)) {}
+    void delete_ptr() { value = nullptr; }
+  };
+
+  static snapshot *make_snapshot(value_type p) {
+    auto *ctrl = shared_ptr_access::block(p);
+    if (!ctrl && !shared_ptr_access::pointer(p)) {
+      return nullptr; // 空指针不需要快照块
+    }
+    if (ctrl) {
+      ctrl->share_across_threads();
+    }
+    return new snapshot(std::move(p));
+  }
+  static bool holds(snapshot *s, const value_type &p) noexcept {
+    T *ptr = s ? shared_ptr_access::pointer(s->value) : nullptr;
+    auto *ctrl = s ? shared_ptr_access::block(s->value) : nullptr;
+    return ptr == shared_ptr_access::pointer(p) &&
+           ctrl == shared_ptr_access::block(p);
+  }
+
+  static std::uint64_t pack(snapshot *s) noexcept {
+    return static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(s));
+  }
+  static snapshot *unpack(std::uint64_t w) noexcept {
+    return reinterpret_cast<snapshot *>(
+        static_cast<std::uintptr_t>(w & pointer_mask));
+  }
+  static int pins(std::uint64_t w) noexcept {
+    return static_cast<int>(w >> pointer_bits);
+  }
+
+  snapshot *pin() const noexcept {
+    return unpack(word.fetch_add(one_pin, std::memory_order_acquire));
+  }
+  void unpin(snapshot *s) const noexcept {
+    std::uint64_t w = word.load(std::memory_order_relaxed);
+    while (unpack(w) == s) {
+      if (word.compare_exchange_weak(w, w - one_pin, std::memory_order_release,
+                                     std::memory_order_relaxed)) {
+        return;
+      }
+    }
+    release_one(s);
+  }
+
+  static void release_one(snapshot *s) noexcept {
+    if (s) {
+      s->release();
+    }
+  }
+  // 交还 AtomicSharedPtr 持有的 bias 个引用，其中 pending 个转给仍钉住它的读者
+  static void retire(snapshot *s, int pending) noexcept {
+    if (!s) {
+      return;
+    }
+    int drop = bias - pending;
+    if (s->ref_cnt.fetch_sub(drop, std::memory_order_acq_rel) == drop) {
+      s->delete_ptr();
+      s->release_weak();
+    }
+  }
+
+  mutable std::atomic<std::uint64_t> word;
+};
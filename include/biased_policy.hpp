@@ -0,0 +1,336 @@
+#pragma once
+#include "control_.hpp"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+#ifndef SMART_PTR_BIASED_SLOTS
+#define SMART_PTR_BIASED_SLOTS 8
+#endif
+
+// 偏向 + 分片的强引用计数，用于被很多线程同时拷贝的热点对象：
+//   BiasedSharedPtr<T> p = make_biased_shared<T>(...);
+//
+// - 创建控制块的线程是它的所属线程 (owner)，在 owner_count 上计数，
+//   只有 load/store，没有 lock 前缀的 RMW。
+// - 其他线程按线程号散列到 SMART_PTR_BIASED_SLOTS 个各占一条缓存行的槽位上计数，
+//   不同线程之间基本不争用同一缓存行。
+// - 只要 owner_count > 0，对象一定活着，其他线程的释放只需在槽位上减 1，
+//   不必判断是否归零。槽位不够减 (引用从别的线程转移过来) 时，这次释放推迟给
+//   owner：记入 pending 并把计数挂到 owner 的队列上，owner 下次在该线程上释放
+//   任意 BiasedSharedPtr 或调用 biased_policy::poll() 时处理。
+// - owner_count 归零时由 owner 合并：置 closed，逐个 exchange 关闭槽位并累加，
+//   结果并入 merged。之后所有线程都只在 merged 上做普通的原子计数。
+//   merged 在合并前带着一个很大的偏置 (large_bias)，合并期间被转到 merged 的
+//   操作怎么交错都不会让它提前归零。
+// - owner 线程退出时合并它名下所有计数，队列交给后续线程或释放方处理。
+//
+// 代价：每个控制块多出约 (槽位数 + 2) 条缓存行，所以只应对真正的热点对象开启；
+// 引用在线程间转移后，对象要等 owner 处理队列后才析构，在此之前 lock() 仍可能成功。
+// 弱计数不在热路径上，仍用 atomic_policy。
+struct biased_policy {
+  using weak_policy = atomic_policy;
+  static constexpr bool deferred_release = true;
+  static constexpr std::size_t slot_count = SMART_PTR_BIASED_SLOTS;
+
+  struct thread_state;
+
+  struct alignas(64) padded_slot {
+    std::atomic<std::int64_t> value{0};
+  };
+
+  struct alignas(64) count_type {
+    explicit count_type(int initial) {
+      thread_state *state = initial > 0 ? owner_state() : nullptr;
+      if (state) {
+        owner = state;
+        owner_count.store(initial, std::memory_order_relaxed);
+        merged.store(large_bias, std::memory_order_relaxed);
+        owned_next = state->owned;
+        if (owned_next) {
+          owned_next->owned_prev = this;
+        }
+        state->owned = this;
+      } else {
+        // 线程正在退出或初始计数为 0 (侵入式计数)：直接以合并后的状态开始
+        closed.store(true, std::memory_order_relaxed);
+        merged.store(initial, std::memory_order_relaxed);
+      }
+    }
+    // 只有控制块构造失败时才会在未合并状态下析构，此时仍在 owner 线程上
+    ~count_type() {
+      if (!closed.load(std::memory_order_relaxed)) {
+        unlink(*this);
+      }
+    }
+    count_type(const count_type &) = delete;
+
+    thread_state *owner = nullptr;
+    std::atomic<std::int64_t> owner_count{0}; // 只由 owner 写入
+    std::atomic<bool> closed{false};
+    std::atomic<std::int64_t> merged{0};
+    std::atomic<std::int64_t> pending{0}; // 推迟给 owner 的释放次数
+    count_type *queue_next = nullptr;
+    count_type *owned_prev = nullptr;
+    count_type *owned_next = nullptr;
+    void *block = nullptr;
+    void (*released)(void *) noexcept = nullptr;
+    padded_slot slots[slot_count];
+  };
+
+  struct thread_state {
+    std::atomic<count_type *> queue{nullptr};
+    std::atomic<bool> alive{true};
+    count_type *owned = nullptr; // 本线程名下尚未合并的计数
+    thread_state *idle_next = nullptr;
+  };
+
+  static void bind(count_type &c, void *block,
+                   void (*released)(void *) noexcept) noexcept {
+    c.block = block;
+    c.released = released;
+  }
+
+  static void increment(count_type &c) noexcept {
+    if (is_owner(c)) {
+      bump_owner(c, 1);
+      return;
+    }
+    if (!c.closed.load(std::memory_order_relaxed) &&
+        slot(c).fetch_add(1, std::memory_order_relaxed) < closed_threshold) {
+      return;
+    }
+    c.merged.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  static bool increment_if_nonzero(count_type &c) noexcept {
+    if (is_owner(c)) {
+      bump_owner(c, 1); // 未合并时 owner_count 一定大于 0
+      return true;
+    }
+    if (!c.closed.load(std::memory_order_relaxed) &&
+        slot(c).fetch_add(1, std::memory_order_relaxed) < closed_threshold) {
+      return true; // 合并时会被计入
+    }
+    std::int64_t value = c.merged.load(std::memory_order_relaxed);
+    while (value != 0) {
+      if (c.merged.compare_exchange_weak(value, value + 1,
+                                         std::memory_order_relaxed,
+                                         std::memory_order_relaxed)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  static bool decrement(count_type &c) noexcept {
+    thread_state *state = current();
+    if (state && c.owner == state) {
+      // 我们自己持有一个引用，处理队列不会让 c 归零
+      if (state->queue.load(std::memory_order_relaxed)) {
+        drain(state, true);
+      }
+      if (!c.closed.load(std::memory_order_relaxed)) {
+        std::int64_t left = bump_owner(c, -1);
+        return left <= 0 && merge(c);
+      }
+    } else if (!c.closed.load(std::memory_order_relaxed)) {
+      std::atomic<std::int64_t> &s = slot(c);
+      std::int64_t value = s.load(std::memory_order_relaxed);
+      while (value < closed_threshold) {
+        if (value <= 0) {
+          defer(c);
+          return false;
+        }
+        if (s.compare_exchange_weak(value, value - 1, std::memory_order_release,
+                                    std::memory_order_relaxed)) {
+          return false;
+        }
+      }
+    }
+    return merged_decrement(c, 1);
+  }
+
+  static int load(const count_type &c) noexcept {
+    if (c.closed.load(std::memory_order_relaxed)) {
+      std::int64_t value = c.merged.load(std::memory_order_relaxed);
+      return static_cast<int>(value >= large_bias / 2 ? value - large_bias
+                                                      : value);
+    }
+    std::int64_t sum = c.owner_count.load(std::memory_order_relaxed);
+    for (const padded_slot &s : c.slots) {
+      sum += s.value.load(std::memory_order_relaxed);
+    }
+    return static_cast<int>(sum);
+  }
+
+  // 处理其他线程推迟给本线程的释放；owner 长时间不释放任何 BiasedSharedPtr 时应定期调用
+  static void poll() noexcept {
+    if (thread_state *state = current()) {
+      drain(state, true);
+    }
+  }
+
+private:
+  static constexpr std::int64_t large_bias = std::int64_t(1) << 40;
+  static constexpr std::int64_t closed_value = std::int64_t(1) << 61;
+  static constexpr std::int64_t closed_threshold = std::int64_t(1) << 60;
+
+  static bool is_owner(const count_type &c) noexcept {
+    thread_state *state = current();
+    return state && c.owner == state &&
+           !c.closed.load(std::memory_order_relaxed);
+  }
+  static std::int64_t bump_owner(count_type &c, std::int64_t delta) noexcept {
+    std::int64_t value = c.owner_count.load(std::memory_order_relaxed) + delta;
+    c.owner_count.store(value, std::memory_order_relaxed);
+    return value;
+  }
+
+  static std::atomic<std::int64_t> &slot(count_type &c) noexcept {
+    static std::atomic<unsigned> next_index{0};
+    static thread_local unsigned index =
+        next_index.fetch_add(1, std::memory_order_relaxed) % slot_count;
+    return c.slots[index].value;
+  }
+
+  static bool merged_decrement(count_type &c, std::int64_t n) noexcept {
+#if defined(__SANITIZE_THREAD__)
+    return c.merged.fetch_sub(n, std::memory_order_acq_rel) == n;
+#else
+    if (c.merged.fetch_sub(n, std::memory_order_release) == n) {
+      std::atomic_thread_fence(std::memory_order_acquire);
+      return true;
+    }
+    return false;
+#endif
+  }
+
+  // 由 owner 调用：关闭全部槽位，把计数并入 merged；返回总数是否已为 0
+  static bool merge(count_type &c) noexcept {
+    c.closed.store(true, std::memory_order_seq_cst);
+    std::int64_t sum = c.owner_count.load(std::memory_order_relaxed);
+    c.owner_count.store(0, std::memory_order_relaxed);
+    for (padded_slot &s : c.slots) {
+      sum += s.value.exchange(closed_value, std::memory_order_acq_rel);
+    }
+    unlink(c);
+    return merged_decrement(c, large_bias - sum);
+  }
+
+  static void unlink(count_type &c) noexcept {
+    if (c.owned_prev) {
+      c.owned_prev->owned_next = c.owned_next;
+    } else {
+      c.owner->owned = c.owned_next;
+    }
+    if (c.owned_next) {
+      c.owned_next->owned_prev = c.owned_prev;
+    }
+    c.owned_prev = c.owned_next = nullptr;
+  }
+
+  static void defer(count_type &c) noexcept {
+    if (c.pending.fetch_add(1, std::memory_order_acq_rel) != 0) {
+      return; // 已经在 owner 的队列里，owner 取走时会一并处理
+    }
+    thread_state *owner = c.owner;
+    count_type *head = owner->queue.load(std::memory_order_relaxed);
+    do {
+      c.queue_next = head;
+    } while (!owner->queue.compare_exchange_weak(
+        head, &c, std::memory_order_release, std::memory_order_relaxed));
+    // owner 已经退出：它名下的计数都已合并，任何线程都可以代为处理
+    if (!owner->alive.load(std::memory_order_seq_cst)) {
+      drain(owner, false);
+    }
+  }
+
+  static void drain(thread_state *state, bool as_owner) noexcept {
+    count_type *c = state->queue.exchange(nullptr, std::memory_order_acquire);
+    while (c) {
+      // 一旦 pending 清零，c 可能立刻被别的线程重新入队，先读出 next
+      count_type *next = c->queue_next;
+      std::int64_t n = c->pending.exchange(0, std::memory_order_acq_rel);
+      bool zero = false;
+      if (as_owner && !c->closed.load(std::memory_order_relaxed)) {
+        zero = bump_owner(*c, -n) <= 0 && merge(*c);
+      } else {
+        zero = merged_decrement(*c, n);
+      }
+      if (zero) {
+        c->released(c->block);
+      }
+      c = next;
+    }
+  }
+
+  // 线程退出时合并名下所有计数并交还 thread_state；thread_state 永不释放，
+  // 迟到的 defer 总能安全地访问它
+  struct state_holder {
+    thread_state *state;
+    state_holder() : state(acquire_state()) { current() = state; }
+    ~state_holder() {
+      current() = nullptr;
+      exited() = true;
+      drain(state, true);
+      while (count_type *c = state->owned) {
+        if (merge(*c)) {
+          c->released(c->block);
+        }
+      }
+      state->alive.store(false, std::memory_order_seq_cst);
+      drain(state, false);
+      release_state(state);
+    }
+  };
+
+  static thread_state *&current() noexcept {
+    static thread_local thread_state *state = nullptr;
+    return state;
+  }
+  static bool &exited() noexcept {
+    static thread_local bool value = false;
+    return value;
+  }
+  static thread_state *owner_state() {
+    if (exited()) {
+      return nullptr;
+    }
+    static thread_local state_holder holder;
+    return holder.state;
+  }
+
+  static std::mutex &states_mutex() {
+    static std::mutex mutex;
+    return mutex;
+  }
+  static thread_state *&idle_states() {
+    static thread_state *head = nullptr;
+    return head;
+  }
+  static thread_state *acquire_state() {
+    std::lock_guard<std::mutex> lock(states_mutex());
+    thread_state *state = idle_states();
+    if (!state) {
+      return new thread_state;
+    }
+    idle_states() = state->idle_next;
+    state->idle_next = nullptr;
+    state->alive.store(true, std::memory_order_seq_cst);
+    return state;
+  }
+  static void release_state(thread_state *state) {
+    std::lock_guard<std::mutex> lock(states_mutex());
+    state->idle_next = idle_states();
+    idle_states() = state;
+  }
+};
+
+template <typename T> using BiasedSharedPtr = SharedPtr<T, biased_policy>;
+template <typename T> using BiasedWeakPtr = WeakPtr<T, biased_policy>;
+
+template <typename T, typename... Args>
+BiasedSharedPtr<T> make_biased_shared(Args &&...args) {
+  return basic_make_shared<T, biased_policy>(std::forward<Args>(args)...);
+}
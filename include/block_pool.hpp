@@ -0,0 +1,306 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+
+// 控制块等小对象的按尺寸分类的线程本地池。
+// - 尺寸按 16 字节向上取整，最大 256 字节，更大的请求直接交给全局 operator new。
+// - 每个线程持有一个 thread_cache：各尺寸类别一条空闲链表，外加一个 64 KiB、
+//   按 64 KiB 对齐的 slab 用于切出新块。块所属的 cache 由地址向下对齐到 slab
+//   起始处的头部得到，块本身不带任何额外头部。
+// - 本线程释放自己 cache 的块直接挂回空闲链表；释放别的线程的块时先在本地攒成一串，
+//   满 remote_batch 个或换了目标 cache 时用一次 CAS 挂到对方的 remote 链表，
+//   对方在空闲链表为空时一次性取走。
+// - 线程退出时 cache 连同其 slab、空闲链表归还全局，由之后创建的线程复用，
+//   因此 cache 本身永不释放，其他线程任何时候都可以往它的 remote 链表里还块。
+// - slab 不归还给系统，池的峰值内存即为其后的常驻内存。
+struct block_pool_stats {
+  std::uint64_t allocations = 0;       // 经过池的分配 (不含超大请求)
+  std::uint64_t hits = 0;              // 其中直接取自空闲链表的
+  std::uint64_t large_allocations = 0; // 超出最大尺寸、转交全局堆的
+  std::uint64_t local_frees = 0;       // 由所属线程释放的
+  std::uint64_t remote_frees = 0;      // 由其他线程释放、需要还给所属线程的
+  std::uint64_t live_blocks = 0;       // 当前仍在使用的池内块
+  std::uint64_t slabs = 0;             // 已向系统申请的 slab 数
+  double hit_rate() const noexcept {
+    return allocations ? static_cast<double>(hits) / allocations : 0.0;
+  }
+};
+
+class block_pool {
+public:
+  static constexpr std::size_t granularity = 16;
+  static constexpr std::size_t max_block_size = 256;
+  static constexpr std::size_t class_count = max_block_size / granularity;
+  static constexpr std::size_t slab_size = 64 * 1024;
+  static constexpr std::size_t remote_batch = 32;
+
+  static void *allocate(std::size_t size) {
+    thread_state *state = current_state();
+    if (size > max_block_size) {
+      if (state) {
+        bump(state->cache->large_allocations);
+      } else {
+        orphan_large_allocations().fetch_add(1, std::memory_order_relaxed);
+      }
+      return ::operator new(size);
+    }
+    std::size_t size_class = size_class_of(size);
+    if (state) {
+      return state->cache->allocate(size_class);
+    }
+    // 线程已经在析构 thread_local 对象，本线程的 cache 已归还，改用加锁的公共 cache
+    std::lock_guard<std::mutex> lock(fallback_mutex());
+    return fallback_cache().allocate(size_class);
+  }
+
+  static void deallocate(void *p, std::size_t size) noexcept {
+    if (!p) {
+      return;
+    }
+    if (size > max_block_size) {
+      ::operator delete(p);
+      return;
+    }
+    auto *block = static_cast<free_block *>(p);
+    block->size_class = size_class_of(size);
+    thread_cache *owner = owner_of(p);
+    thread_state *state = current_state();
+    if (state && state->cache == owner) {
+      block->next = owner->free_list[block->size_class];
+      owner->free_list[block->size_class] = block;
+      bump(owner->local_frees);
+    } else if (state) {
+      state->push_remote(owner, block);
+      bump(state->cache->remote_frees);
+    } else {
+      block->next = nullptr;
+      push_remote_chain(owner, block, block);
+      orphan_frees().fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  // 汇总所有 cache 的计数；各计数分别读取，并发分配时只是近似值
+  static block_pool_stats stats() {
+    block_pool_stats result;
+    std::uint64_t frees = orphan_frees().load(std::memory_order_relaxed);
+    auto add = [&](const thread_cache &cache) {
+      result.allocations += load(cache.allocations);
+      result.hits += load(cache.hits);
+      result.large_allocations += load(cache.large_allocations);
+      result.local_frees += load(cache.local_frees);
+      result.remote_frees += load(cache.remote_frees);
+      result.slabs += load(cache.slab_count);
+    };
+    {
+      std::lock_guard<std::mutex> lock(registry_mutex());
+      for (thread_cache *c = registry_head(); c; c = c->all_next) {
+        add(*c);
+      }
+    }
+    {
+      std::lock_guard<std::mutex> lock(fallback_mutex());
+      add(fallback_cache());
+    }
+    result.large_allocations +=
+        orphan_large_allocations().load(std::memory_order_relaxed);
+    result.remote_frees += frees;
+    std::uint64_t freed = result.local_frees + result.remote_frees;
+    result.live_blocks =
+        result.allocations > freed ? result.allocations - freed : 0;
+    return result;
+  }
+
+private:
+  // 空闲块复用块自身的内存：链表指针 + 尺寸类别 (远程归还时由释放方写入)
+  struct free_block {
+    free_block *next;
+    std::size_t size_class;
+  };
+  struct thread_cache;
+  struct alignas(64) slab_header {
+    thread_cache *owner;
+    slab_header *next;
+  };
+
+  // 计数只由持有该 cache 的线程写入，用 load + store 代替 RMW，避免 lock 前缀
+  using counter = std::atomic<std::uint64_t>;
+  static void bump(counter &c) noexcept {
+    c.store(c.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  }
+  static std::uint64_t load(const counter &c) noexcept {
+    return c.load(std::memory_order_relaxed);
+  }
+
+  struct thread_cache {
+    free_block *free_list[class_count] = {};
+    std::atomic<free_block *> remote{nullptr};
+    char *cursor = nullptr;
+    char *slab_end = nullptr;
+    slab_header *slabs = nullptr;
+    counter allocations{0};
+    counter hits{0};
+    counter large_allocations{0};
+    counter local_frees{0};
+    counter remote_frees{0};
+    counter slab_count{0};
+    thread_cache *all_next = nullptr;  // 所有 cache，供 stats 遍历
+    thread_cache *idle_next = nullptr; // 等待被新线程复用的 cache
+
+    void *allocate(std::size_t size_class) {
+      bump(allocations);
+      free_block *block = free_list[size_class];
+      if (!block) {
+        drain_remote();
+        block = free_list[size_class];
+      }
+      if (block) {
+        free_list[size_class] = block->next;
+        bump(hits);
+        return block;
+      }
+      return carve((size_class + 1) * granularity);
+    }
+
+    void drain_remote() noexcept {
+      free_block *block = remote.exchange(nullptr, std::memory_order_acquire);
+      while (block) {
+        free_block *next = block->next;
+        block->next = free_list[block->size_class];
+        free_list[block->size_class] = block;
+        block = next;
+      }
+    }
+
+    void *carve(std::size_t bytes) {
+      if (static_cast<std::size_t>(slab_end - cursor) < bytes) {
+        void *memory = ::operator new(slab_size, std::align_val_t(slab_size));
+        auto *header = ::new (memory) slab_header{this, slabs};
+        slabs = header;
+        bump(slab_count);
+        cursor = static_cast<char *>(memory) + sizeof(slab_header);
+        slab_end = static_cast<char *>(memory) + slab_size;
+      }
+      void *block = cursor;
+      cursor += bytes;
+      return block;
+    }
+  };
+
+  // 每个线程一个：持有 cache 以及发往其他 cache 的待归还块
+  struct thread_state {
+    thread_cache *cache;
+    thread_cache *batch_owner = nullptr;
+    free_block *batch_head = nullptr;
+    free_block *batch_tail = nullptr;
+    std::size_t batch_size = 0;
+
+    thread_state() : cache(acquire_cache()) {}
+    ~thread_state() {
+      flush();
+      release_cache(cache);
+      thread_exited() = true;
+    }
+    thread_state(const thread_state &) = delete;
+
+    void push_remote(thread_cache *owner, free_block *block) noexcept {
+      if (owner != batch_owner) {
+        flush();
+        batch_owner = owner;
+      }
+      block->next = batch_head;
+      batch_head = block;
+      if (!batch_tail) {
+        batch_tail = block;
+      }
+      if (++batch_size >= remote_batch) {
+        flush();
+      }
+    }
+    void flush() noexcept {
+      if (batch_head) {
+        push_remote_chain(batch_owner, batch_head, batch_tail);
+      }
+      batch_head = batch_tail = nullptr;
+      batch_size = 0;
+    }
+  };
+
+  static std::size_t size_class_of(std::size_t size) noexcept {
+    return size ? (size - 1) / granularity : 0;
+  }
+  static thread_cache *owner_of(void *p) noexcept {
+    auto address = reinterpret_cast<std::uintptr_t>(p);
+    return reinterpret_cast<slab_header *>(address & ~(slab_size - 1))->owner;
+  }
+  static void push_remote_chain(thread_cache *owner, free_block *head,
+                                free_block *tail) noexcept {
+    free_block *old = owner->remote.load(std::memory_order_relaxed);
+    do {
+      tail->next = old;
+    } while (!owner->remote.compare_exchange_weak(
+        old, head, std::memory_order_release, std::memory_order_relaxed));
+  }
+
+  static bool &thread_exited() noexcept {
+    static thread_local bool exited = false;
+    return exited;
+  }
+  // 线程退出阶段 (thread_state 已析构) 返回 nullptr
+  static thread_state *current_state() {
+    if (thread_exited()) {
+      return nullptr;
+    }
+    static thread_local thread_state state;
+    return &state;
+  }
+
+  static std::mutex &registry_mutex() {
+    static std::mutex mutex;
+    return mutex;
+  }
+  static thread_cache *&registry_head() {
+    static thread_cache *head = nullptr;
+    return head;
+  }
+  static thread_cache *&idle_head() {
+    static thread_cache *head = nullptr;
+    return head;
+  }
+  static thread_cache *acquire_cache() {
+    std::lock_guard<std::mutex> lock(registry_mutex());
+    if (thread_cache *cache = idle_head()) {
+      idle_head() = cache->idle_next;
+      cache->idle_next = nullptr;
+      return cache;
+    }
+    auto *cache = new thread_cache;
+    cache->all_next = registry_head();
+    registry_head() = cache;
+    return cache;
+  }
+  static void release_cache(thread_cache *cache) {
+    std::lock_guard<std::mutex> lock(registry_mutex());
+    cache->idle_next = idle_head();
+    idle_head() = cache;
+  }
+
+  static std::mutex &fallback_mutex() {
+    static std::mutex mutex;
+    return mutex;
+  }
+  static thread_cache &fallback_cache() {
+    static thread_cache cache;
+    return cache;
+  }
+  static std::atomic<std::uint64_t> &orphan_frees() {
+    static std::atomic<std::uint64_t> count{0};
+    return count;
+  }
+  static std::atomic<std::uint64_t> &orphan_large_allocations() {
+    static std::atomic<std::uint64_t> count{0};
+    return count;
+  }
+};
@@ -1,53 +1,492 @@
 #pragma once
+#include "block_pool.hpp"
+#include "ebo_storage.hpp"
 #include "func.hpp"
+#include "instrument.hpp"
 #include <atomic>
 #include <iostream>
-using namespace std;
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
 
-struct control_block_base {
+// 引用计数协议：
+// weak_cnt = WeakPtr 的数量 + 1，这多出来的 1 由全体强引用共同持有，
+// 最后一个强引用析构对象之后才把它释放。这样只有把 weak_cnt 减到 0 的那个线程
+// 会删除控制块，两边都不需要再读对方的计数 (否则最后一个 SharedPtr 与最后一个
+// WeakPtr 同时释放时，双方都可能看到对方为 0 而重复 delete)。
+//
+// 计数的具体实现由 Policy 决定，Policy 需要提供：
+//   count_type                        计数器类型
+//   increment(c)                      加 1
+//   increment_if_nonzero(c)           非 0 时加 1，返回是否成功 (lock 用)
+//   decrement(c)                      减 1，返回是否减到了 0
+//   load(c)                           读取当前值 (仅用于 use_count)
+// 可选：
+//   add(c, n) / subtract(c, n)        一次加/减 n (share_n、release_range 用)，
+//                                     没有时退化为逐个 increment/decrement
+//   weak_policy                       弱计数改用另一个 Policy (默认与强计数相同)
+//   deferred_release = true 与 bind(c, block, released)
+//                                     decrement 无法当场判定归零的 Policy，
+//                                     稍后在别处发现归零时调用 released(block)
+//   promote(c)                        计数即将被其他线程访问时调用，
+//                                     只在创建线程上计数的 Policy 借此切换为原子计数
+
+// 默认策略：原子计数，可以跨线程共享。内存序：
+// - 增加计数 (拷贝 SharedPtr/WeakPtr) 用 relaxed：新引用总是从一个已有引用得到的，
+//   对象在此期间不可能被释放，也没有需要发布的数据。
+// - lock() 只在强计数非 0 时加 1，成功时同样只需 relaxed，理由同上。
+// - 减少计数用 release，只有减到 0 的线程再补一个 acquire fence：
+//   其他线程通过各自引用对对象做的写入，都会在析构/释放之前对这个线程可见，
+//   而普通的 (非最后一次) 释放不用付 acquire 的代价。
+struct atomic_policy {
+  using count_type = std::atomic<int>;
+  static void increment(count_type &count) noexcept {
+    count.fetch_add(1, std::memory_order_relaxed);
+  }
+  static bool increment_if_nonzero(count_type &count) noexcept {
+    int value = count.load(std::memory_order_relaxed);
+    while (value != 0) {
+      if (count.compare_exchange_weak(value, value + 1,
+                                      std::memory_order_relaxed,
+                                      std::memory_order_relaxed)) {
+        return true;
+      }
+    }
+    return false;
+  }
+  static bool decrement(count_type &count) noexcept {
+    return subtract(count, 1);
+  }
+  static void add(count_type &count, int n) noexcept {
+    count.fetch_add(n, std::memory_order_relaxed);
+  }
+  // 减到 0 时已经补上了 acquire
+  static bool subtract(count_type &count, int n) noexcept {
+#if defined(__SANITIZE_THREAD__)
+    // ThreadSanitizer 不理解独立的 fence，在其下改用 acq_rel 以免误报
+    return count.fetch_sub(n, std::memory_order_acq_rel) == n;
+#else
+    if (count.fetch_sub(n, std::memory_order_release) == n) {
+      std::atomic_thread_fence(std::memory_order_acquire);
+      return true;
+    }
+    return false;
+#endif
+  }
+  static int load(const count_type &count) noexcept {
+    return count.load(std::memory_order_relaxed);
+  }
+};
+
+// 单线程策略：普通 int 计数，没有 lock 前缀的 RMW。
+// 只适用于对象及其所有 SharedPtr/WeakPtr 都不离开创建线程的场景
+struct local_policy {
+  using count_type = int;
+  static void increment(count_type &count) noexcept { ++count; }
+  static bool increment_if_nonzero(count_type &count) noexcept {
+    if (count == 0) {
+      return false;
+    }
+    ++count;
+    return true;
+  }
+  static bool decrement(count_type &count) noexcept { return --count == 0; }
+  static void add(count_type &count, int n) noexcept { count += n; }
+  static bool subtract(count_type &count, int n) noexcept {
+    return (count -= n) == 0;
+  }
+  static int load(const count_type &count) noexcept { return count; }
+};
+
+template <typename Policy, typename = void> struct weak_policy_of {
+  using type = Policy;
+};
+template <typename Policy>
+struct weak_policy_of<Policy, std::void_t<typename Policy::weak_policy>> {
+  using type = typename Policy::weak_policy;
+};
+
+template <typename Policy, typename = void>
+struct has_deferred_release : std::false_type {};
+template <typename Policy>
+struct has_deferred_release<Policy,
+                            std::void_t<decltype(Policy::deferred_release)>>
+    : std::integral_constant<bool, Policy::deferred_release> {};
+
+template <typename Policy, typename = void>
+struct has_promote : std::false_type {};
+template <typename Policy>
+struct has_promote<Policy, std::void_t<decltype(Policy::promote(
+                               std::declval<typename Policy::count_type &>()))>>
+    : std::true_type {};
+
+// 计数只能在一个线程上使用的策略，AtomicSharedPtr 拒绝它们。
+// 包装其他策略的 Policy (padded_policy) 随被包装的策略特化
+template <typename Policy>
+struct is_single_thread_policy : std::is_same<Policy, local_policy> {};
+
+template <typename Policy, typename = void>
+struct has_bulk_count : std::false_type {};
+template <typename Policy>
+struct has_bulk_count<
+    Policy, std::void_t<decltype(Policy::subtract(
+                std::declval<typename Policy::count_type &>(), 1))>>
+    : std::true_type {};
+
+template <typename Policy> struct basic_control_block_base {
 public:
-  std::atomic<int> ref_cnt;
-  std::atomic<int> weak_cnt;
-  control_block_base(int r, int w) : ref_cnt(r), weak_cnt(w) {}
+  using policy_type = Policy;
+  using weak_policy = typename weak_policy_of<Policy>::type;
+  // 弱计数在前：默认策略下 vptr + 两个计数正好 16 字节；count_type 按缓存行对齐
+  // 的策略 (padded_policy.hpp) 下 vptr 与弱计数共用第一行，强计数独占第二行
+  typename weak_policy::count_type weak_cnt;
+  typename Policy::count_type ref_cnt;
+  basic_control_block_base(int r, int w) : weak_cnt(w), ref_cnt(r) {
+    if constexpr (has_deferred_release<Policy>::value) {
+      Policy::bind(ref_cnt, this, &released_elsewhere);
+    }
+  }
   virtual void delete_ptr() = 0;
-  virtual ~control_block_base() {}
+  // 释放控制块本身；内存不是来自 operator new 的控制块 (allocate_shared) 重写它
+  virtual void destroy() noexcept { delete this; }
+  // 最后一个强引用离开时的唯一一次虚调用：析构对象并归还强引用共同持有的弱引用。
+  // 最终类型确定的控制块 (sealed_block 等) 重写它，使对象的析构函数与控制块的释放
+  // 都在这一次调用里静态绑定、可以内联，而不是再经 delete_ptr/destroy/析构函数
+  // 三次间接调用
+  virtual void release_last() noexcept {
+    delete_ptr();
+    release_weak();
+  }
+  virtual ~basic_control_block_base() {}
+
+  void add_ref() noexcept { Policy::increment(ref_cnt); }
+  // 强计数已为 0 时失败 (对象已经或正在被析构)
+  bool try_add_ref() noexcept { return Policy::increment_if_nonzero(ref_cnt); }
+  void release() noexcept {
+    if (Policy::decrement(ref_cnt)) {
+      release_last();
+    }
+  }
+  // 一次持有/释放 n 个强引用
+  void add_ref(int n) noexcept {
+    if constexpr (has_bulk_count<Policy>::value) {
+      Policy::add(ref_cnt, n);
+    } else {
+      for (int i = 0; i < n; ++i) {
+        Policy::increment(ref_cnt);
+      }
+    }
+  }
+  void release(int n) noexcept {
+    bool zero = false;
+    if constexpr (has_bulk_count<Policy>::value) {
+      zero = Policy::subtract(ref_cnt, n);
+    } else {
+      // 我们持有这 n 个引用，只有最后一次可能减到 0
+      for (int i = 0; i < n; ++i) {
+        zero = Policy::decrement(ref_cnt);
+      }
+    }
+    if (zero) {
+      release_last();
+    }
+  }
+  void add_weak() noexcept { weak_policy::increment(weak_cnt); }
+  void release_weak() noexcept {
+    if (drop_weak()) {
+      destroy();
+    }
+  }
+  // 只减弱计数，返回是否轮到调用者释放控制块；供最终类型的 release_last 直接
+  // 调用自己的 destroy，而不经过这里的虚调用
+  bool drop_weak() noexcept { return weak_policy::decrement(weak_cnt); }
+  int use_count() const noexcept { return Policy::load(ref_cnt); }
+  // 引用即将交给其他线程；调用方须在当前能访问计数的线程上、交出引用之前调用。
+  // 对始终原子计数的 Policy 是空操作
+  void share_across_threads() noexcept {
+    if constexpr (has_promote<Policy>::value) {
+      Policy::promote(ref_cnt);
+    }
+    if constexpr (has_promote<weak_policy>::value) {
+      weak_policy::promote(weak_cnt);
+    }
+  }
+
+private:
+  // 供 deferred_release 的 Policy 在 decrement 之外发现强计数归零时回调
+  static void released_elsewhere(void *self) noexcept {
+    static_cast<basic_control_block_base *>(self)->release_last();
+  }
+
+public:
+
+#ifndef SMART_PTR_DISABLE_BLOCK_POOL
+  // 控制块 (以及 make_shared 的对象) 从线程本地池分配，见 block_pool.hpp；
+  // 定义 SMART_PTR_DISABLE_BLOCK_POOL 退回全局堆。
+  // 析构函数是虚的，delete 时传入的是实际派生类型的大小
+  static void *operator new(std::size_t size) {
+    return block_pool::allocate(size);
+  }
+  static void operator delete(void *p, std::size_t size) noexcept {
+    block_pool::deallocate(p, size);
+  }
+  // 超过默认对齐的类型不进池
+  static void *operator new(std::size_t size, std::align_val_t align) {
+    return ::operator new(size, align);
+  }
+  static void operator delete(void *p, std::size_t size,
+                              std::align_val_t align) noexcept {
+    ::operator delete(p, size, align);
+  }
+  // 类作用域的 operator new 会隐藏全局的 placement new，这里补回来
+  static void *operator new(std::size_t, void *where) noexcept {
+    return where;
+  }
+  static void operator delete(void *, void *) noexcept {}
+#endif
 };
 
-template <typename T> class control_block : public control_block_base {
+using control_block_base = basic_control_block_base<atomic_policy>;
+using local_control_block_base = basic_control_block_base<local_policy>;
+static_assert(sizeof(void *) != 8 || sizeof(control_block_base) == 16,
+              "the default control block header should stay 16 bytes");
+
+// 裸指针默认的删除器，T[] 与 T[N] 都用 delete[]
+template <typename T>
+using default_delete_for = std::default_delete<
+    std::conditional_t<std::is_array<T>::value, std::remove_extent_t<T>[], T>>;
+
+// 删除器类型 D 直接存放在控制块里：默认的 std::default_delete 经 EBO 不占空间，
+// delete_ptr 这一次虚调用之后就是对 D 的直接调用，无需再分配/间接调用 mystd::function
+template <typename T, typename D = default_delete_for<T>,
+          typename Policy = atomic_policy>
+class control_block : public basic_control_block_base<Policy>,
+                      private ebo_storage<D> {
 public:
-  mystd::function<void(T *)> deleter;
-  T *ptr;
-  void delete_ptr() { deleter(ptr); }
-  control_block() {}
-  control_block(T *p)
-      : ptr(p), deleter([](T *p) -> void { delete p; }),
-        control_block_base(1, 0) {}
-  control_block(T *p, mystd::function<void(T *)> d)
-      : ptr(p), deleter(d), control_block_base(1, 0) {}
+  using element_type = std::remove_extent_t<T>;
+  element_type *ptr;
+  void delete_ptr() {
+    SMART_PTR_COUNT(T, objects_destroyed);
+    this->get()(ptr);
+  }
+  explicit control_block(element_type *p)
+      : basic_control_block_base<Policy>(1, 1), ptr(p) {
+    SMART_PTR_COUNT(T, block_allocations);
+    SMART_PTR_COUNT(T, objects_created);
+  }
+  control_block(element_type *p, D d)
+      : basic_control_block_base<Policy>(1, 1), ebo_storage<D>(std::move(d)),
+        ptr(p) {
+    SMART_PTR_COUNT(T, block_allocations);
+    SMART_PTR_COUNT(T, objects_created);
+  }
   control_block(const control_block &other) = delete;
   ~control_block() {}
 };
 
-template <typename T> class WeakPtr;
+// make_shared 使用的控制块：对象与引用计数放在同一次分配里
+template <typename T, typename Policy = atomic_policy>
+class control_block_inplace : public basic_control_block_base<Policy> {
+public:
+  alignas(T) unsigned char storage[sizeof(T)];
+  template <typename... Args>
+  explicit control_block_inplace(Args &&...args)
+      : basic_control_block_base<Policy>(1, 1) {
+    ::new (static_cast<void *>(storage)) T(std::forward<Args>(args)...);
+    SMART_PTR_COUNT(T, block_allocations);
+    SMART_PTR_COUNT(T, objects_created);
+  }
+  T *get() noexcept { return std::launder(reinterpret_cast<T *>(storage)); }
+  // 最后一个强引用只析构对象，内存随控制块在最后一个弱引用时释放
+  void delete_ptr() {
+    SMART_PTR_COUNT(T, objects_destroyed);
+    get()->~T();
+  }
+  control_block_inplace(const control_block_inplace &other) = delete;
+  ~control_block_inplace() {}
+};
+
+// 把 control_block / control_block_inplace 封成最终类型，SharedPtr 的构造与
+// make_shared 实际分配的都是它：release_last 与 destroy 里对 delete_ptr 和析构函数
+// 的调用都静态绑定，T 的析构函数 (及删除器) 直接内联进这一次虚调用。
+// deferred_block 等混入继承的仍是未封闭的 Block
+template <typename Block> class sealed_block final : public Block {
+public:
+  using Block::Block;
+  void release_last() noexcept override {
+    Block::delete_ptr();
+    if (this->drop_weak()) {
+      delete this;
+    }
+  }
+  void destroy() noexcept override { delete this; }
+};
+
+// allocate_shared 使用的控制块：对象与计数放在同一次由 Alloc 完成的分配里。
+// 分配器 rebind 到控制块类型后保存在块内 (无状态的分配器经 EBO 不占空间)，
+// 对象用它构造/析构，最后一个弱引用释放时再用它归还整块内存
+template <typename T, typename Alloc, typename Policy = atomic_policy>
+class control_block_alloc final
+    : public basic_control_block_base<Policy>,
+      private ebo_storage<typename std::allocator_traits<
+          Alloc>::template rebind_alloc<control_block_alloc<T, Alloc, Policy>>> {
+public:
+  using allocator_type = typename std::allocator_traits<
+      Alloc>::template rebind_alloc<control_block_alloc>;
+  using value_allocator =
+      typename std::allocator_traits<Alloc>::template rebind_alloc<T>;
+  alignas(T) unsigned char storage[sizeof(T)];
+
+  template <typename... Args>
+  explicit control_block_alloc(const allocator_type &a, Args &&...args)
+      : basic_control_block_base<Policy>(1, 1), ebo_storage<allocator_type>(a) {
+    value_allocator value_alloc(allocator());
+    std::allocator_traits<value_allocator>::construct(
+        value_alloc, get(), std::forward<Args>(args)...);
+    SMART_PTR_COUNT(T, block_allocations);
+    SMART_PTR_COUNT(T, objects_created);
+  }
+  T *get() noexcept { return std::launder(reinterpret_cast<T *>(storage)); }
+  void delete_ptr() {
+    SMART_PTR_COUNT(T, objects_destroyed);
+    value_allocator value_alloc(allocator());
+    std::allocator_traits<value_allocator>::destroy(value_alloc, get());
+  }
+  void destroy() noexcept override {
+    allocator_type a(allocator());
+    this->~control_block_alloc();
+    std::allocator_traits<allocator_type>::deallocate(a, this, 1);
+  }
+  // 类是 final 的，这里对 delete_ptr / destroy 的调用都是静态绑定的
+  void release_last() noexcept override {
+    delete_ptr();
+    if (this->drop_weak()) {
+      destroy();
+    }
+  }
+  control_block_alloc(const control_block_alloc &other) = delete;
+  ~control_block_alloc() {}
+
+private:
+  allocator_type &allocator() noexcept {
+    return ebo_storage<allocator_type>::get();
+  }
+};
+
+// make_shared<T[]> 使用的控制块：n 个元素紧跟在控制块后面，一次分配。
+// 整块按 max(64, alignof(T)) 对齐，元素从缓存行边界开始
+template <typename T, typename Policy = atomic_policy>
+class control_block_array final : public basic_control_block_base<Policy> {
+public:
+  static_assert(!std::is_array<T>::value,
+                "multidimensional arrays are not supported");
+  static constexpr std::size_t alignment = alignof(T) > 64 ? alignof(T) : 64;
+
+  // default_init 为 true 时元素默认初始化 (平凡类型保持未初始化)，否则值初始化
+  static control_block_array *create(std::size_t n, bool default_init) {
+    if (n > (std::size_t(-1) - header_size()) / sizeof(T)) {
+      throw std::bad_array_new_length();
+    }
+    void *memory = ::operator new(header_size() + n * sizeof(T),
+                                  std::align_val_t(alignment));
+    auto *block = ::new (memory) control_block_array(n);
+    try {
+      if (default_init) {
+        std::uninitialized_default_construct_n(block->get(), n);
+      } else {
+        std::uninitialized_value_construct_n(block->get(), n);
+      }
+    } catch (...) {
+      block->~control_block_array();
+      ::operator delete(memory, std::align_val_t(alignment));
+      throw;
+    }
+    SMART_PTR_COUNT(T, block_allocations);
+    SMART_PTR_COUNT(T, objects_created);
+    return block;
+  }
+
+  T *get() noexcept {
+    return std::launder(reinterpret_cast<T *>(
+        reinterpret_cast<unsigned char *>(this) + header_size()));
+  }
+  std::size_t size() const noexcept { return count; }
+  // 与 delete[] 一样逆序析构
+  void delete_ptr() {
+    SMART_PTR_COUNT(T, objects_destroyed);
+    T *first = get();
+    for (std::size_t i = count; i > 0; --i) {
+      first[i - 1].~T();
+    }
+  }
+  void destroy() noexcept override {
+    this->~control_block_array();
+    ::operator delete(static_cast<void *>(this), std::align_val_t(alignment));
+  }
+  void release_last() noexcept override {
+    delete_ptr();
+    if (this->drop_weak()) {
+      destroy();
+    }
+  }
+  control_block_array(const control_block_array &other) = delete;
+  ~control_block_array() {}
+
+private:
+  explicit control_block_array(std::size_t n)
+      : basic_control_block_base<Policy>(1, 1), count(n) {}
+  static constexpr std::size_t header_size() noexcept {
+    return (sizeof(control_block_array) + alignment - 1) / alignment *
+           alignment;
+  }
+  std::size_t count;
+};
+
+template <typename T, typename Policy = atomic_policy> class WeakPtr;
+struct shared_ptr_access;
 
-template <typename T> class SharedPtr {
+// Policy 决定计数方式：默认 atomic_policy 可跨线程，local_policy 仅限单线程。
+// 不同 Policy 的指针之间不能互相转换
+template <typename T, typename Policy = atomic_policy> class SharedPtr {
 private:
-  template <typename Y> friend class SharedPtr;
-  template <typename X> friend class WeakPtr;
-  T *ptr;
-  control_block_base *ctrl;
-  SharedPtr(T *p, control_block_base *c) : ptr(p), ctrl(c) {}
+  template <typename, typename> friend class SharedPtr;
+  template <typename, typename> friend class WeakPtr;
+  friend struct shared_ptr_access;
+  using block_type = basic_control_block_base<Policy>;
+  std::remove_extent_t<T> *ptr;
+  block_type *ctrl;
+  SharedPtr(std::remove_extent_t<T> *p, block_type *c) : ptr(p), ctrl(c) {}
 
 public:
+  // T 为数组 (T[] / T[N]) 时指向首元素
+  using element_type = std::remove_extent_t<T>;
+
   SharedPtr() noexcept : ptr(nullptr), ctrl(nullptr) {}
-  SharedPtr(T *p) : ptr(p), ctrl(new control_block<T>(p)) {}
-  SharedPtr(T *p, mystd::function<void(T *)> d)
-      : ptr(p), ctrl(new control_block<T>(p, d)) {}
-  SharedPtr(const SharedPtr &other) {
-    if (other.ctrl) {
-      other.ctrl->ref_cnt.fetch_add(1, std::memory_order_release);
-      ctrl = other.ctrl;
-      ptr = other.ptr;
+  SharedPtr(element_type *p) : ptr(p), ctrl(nullptr) {
+    try {
+      ctrl = new sealed_block<
+          control_block<T, default_delete_for<T>, Policy>>(p);
+    } catch (...) {
+      default_delete_for<T>()(p);
+      throw;
+    }
+    enable_shared_from_this_hook(*this, ptr);
+  }
+  template <typename D>
+  SharedPtr(element_type *p, D d) : ptr(p), ctrl(nullptr) {
+    try {
+      ctrl = new sealed_block<control_block<T, D, Policy>>(p, d);
+    } catch (...) {
+      d(p);
+      throw;
+    }
+    enable_shared_from_this_hook(*this, ptr);
+  }
+  SharedPtr(const SharedPtr &other) : ptr(other.ptr), ctrl(other.ctrl) {
+    if (ctrl) {
+      SMART_PTR_COUNT(T, copies);
+      ctrl->add_ref();
     }
   }
   SharedPtr(SharedPtr &&other) noexcept {
@@ -56,7 +495,7 @@ public:
     other.ctrl = nullptr;
     other.ptr = nullptr;
   }
-  T *get() { return ptr; }
+  element_type *get() { return ptr; }
   explicit operator bool() { return ptr != nullptr; }
   SharedPtr &operator=(const SharedPtr &other) {
     if (this == &other) {
@@ -75,62 +514,121 @@ public:
     ptr = other.ptr;
     other.ctrl = nullptr;
     other.ptr = nullptr;
+    return *this;
+  }
+  element_type &operator*() { return *ptr; }
+  element_type *operator->() { return ptr; }
+  element_type &operator[](std::ptrdiff_t i) {
+    static_assert(std::is_array<T>::value, "operator[] requires an array type");
+    return ptr[i];
   }
-  T &operator*() { return *ptr; }
-  T *operator->() { return ptr; }
   void release() {
     if (!ctrl)
       return; // 由于可能对空指针赋值 必须当心
-    if (ctrl->ref_cnt.fetch_sub(1, std::memory_order_acq_rel) == 1) {
-      ctrl->delete_ptr();
-      if (ctrl->weak_cnt.load(std::memory_order_acquire) == 0) {
-        delete ctrl;
+    SMART_PTR_COUNT(T, releases);
+    ctrl->release();
+  }
+  int use_count() const noexcept { return ctrl ? ctrl->use_count() : 0; }
+  // 把自己拷贝 n 份依次写入 out，引用计数只加一次 n
+  template <typename OutputIt>
+  OutputIt share_n(OutputIt out, std::size_t n) const {
+    if (ctrl && n) {
+      SMART_PTR_COUNT_N(T, copies, n);
+      ctrl->add_ref(static_cast<int>(n));
+    }
+    std::size_t made = 0;
+    try {
+      for (; made < n; ++made) {
+        *out = SharedPtr(ptr, ctrl);
+        ++out;
+      }
+    } catch (...) {
+      // 抛出异常的那一份由临时对象自己释放，剩下的预先加上的引用在这里还回去
+      if (ctrl && n - made > 1) {
+        ctrl->release(static_cast<int>(n - made - 1));
       }
-    };
+      throw;
+    }
+    return out;
+  }
+  // detach 交出的引用：元素指针与控制块原样保存，经过改变地址的转换
+  // (多重继承的基类、别名构造) 得到的指针也能还原。两个指针的平凡结构，
+  // 可以按值穿过不透明的边界 (例如把它的地址作为 void* 传给 C 回调)
+  struct handle {
+    element_type *ptr = nullptr;
+    block_type *ctrl = nullptr;
+  };
+  // 交出所有权而不改动计数并把自己置空，之后必须用 adopt 还原，否则引用泄漏
+  handle detach() noexcept {
+    handle h{ptr, ctrl};
+    ptr = nullptr;
+    ctrl = nullptr;
+    return h;
   }
+  // 接管 detach 得到的句柄，不增加计数
+  static SharedPtr adopt(handle h) noexcept { return SharedPtr(h.ptr, h.ctrl); }
   ~SharedPtr() { release(); }
   void swap(SharedPtr &other) noexcept {
-    control_block_base *temp_ctrl = other.ctrl;
+    block_type *temp_ctrl = other.ctrl;
     other.ctrl = ctrl;
     ctrl = temp_ctrl;
-    T *temp_p = other.ptr;
+    element_type *temp_p = other.ptr;
     other.ptr = ptr;
     ptr = temp_p;
   }
   template <typename U>
-  SharedPtr(SharedPtr<U> &other) : ctrl(nullptr), ptr(nullptr) {
+  SharedPtr(SharedPtr<U, Policy> &other) : ptr(nullptr), ctrl(nullptr) {
     static_assert(std::is_convertible<U *, T *>::value,
                   "U* must be convertible to T*");
     if (other.ctrl) {
-      other.ctrl->ref_cnt.fetch_add(1, std::memory_order_release);
-      ptr = static_cast<T *>(other.ptr);
+      SMART_PTR_COUNT(T, copies);
+      other.ctrl->add_ref();
+      ptr = static_cast<element_type *>(other.ptr);
       ctrl = other.ctrl;
     }
   }
-  template <typename U> SharedPtr &operator=(SharedPtr<U> &other) {
+  template <typename U> SharedPtr &operator=(SharedPtr<U, Policy> &other) {
     static_assert(std::is_convertible<U *, T *>::value,
                   "U* must be convertible to T*");
 
-    SharedPtr<T> temp(other);
+    SharedPtr temp(other);
     swap(temp);
     return *this;
   }
-  template <typename U> SharedPtr(SharedPtr<U> &&other) noexcept {
+  template <typename U> SharedPtr(SharedPtr<U, Policy> &&other) noexcept {
     static_assert(std::is_convertible<U *, T *>::value,
                   "U* must be convertible to T*");
-    ptr = static_cast<T *>(other.ptr);
+    ptr = static_cast<element_type *>(other.ptr);
     ctrl = other.ctrl;
     other.ctrl = nullptr;
     other.ptr = nullptr;
   }
-  template <typename U> SharedPtr &operator=(SharedPtr<U> &&other) noexcept {
+  template <typename U> SharedPtr &operator=(SharedPtr<U, Policy> &&other) noexcept {
     static_assert(std::is_convertible<U *, T *>::value,
                   "U* must be convertible to T*");
     release();
-    ptr = static_cast<T *>(other.ptr);
+    ptr = static_cast<element_type *>(other.ptr);
     ctrl = other.ctrl;
     other.ctrl = nullptr;
     other.ptr = nullptr;
+    return *this;
+  }
+  // 别名构造：与 other 共用控制块 (计数、析构方式都跟着 other)，但 get() 返回 p，
+  // 用于指向 other 所管理对象的某个成员或数组元素，不需要另外分配控制块
+  template <typename U>
+  SharedPtr(const SharedPtr<U, Policy> &other, element_type *p) noexcept
+      : ptr(p), ctrl(other.ctrl) {
+    if (ctrl) {
+      SMART_PTR_COUNT(T, copies);
+      ctrl->add_ref();
+    }
+  }
+  // 右值版本直接接管 other 的引用，不碰计数
+  template <typename U>
+  SharedPtr(SharedPtr<U, Policy> &&other, element_type *p) noexcept
+      : ptr(p), ctrl(other.ctrl) {
+    other.ctrl = nullptr;
+    other.ptr = nullptr;
   }
   SharedPtr &operator=(std::nullptr_t) noexcept {
     release();
@@ -139,28 +637,27 @@ public:
     return *this;
   }
 };
-template <typename T> class WeakPtr {
+template <typename T, typename Policy> class WeakPtr {
 private:
-  template <typename U> friend class SharedPtr;
-  control_block_base *ctrl;
-  template <typename U> friend class WeakPtr;
-  T *ptr;
+  template <typename, typename> friend class SharedPtr;
+  basic_control_block_base<Policy> *ctrl;
+  template <typename, typename> friend class WeakPtr;
+  friend struct shared_ptr_access;
+  std::remove_extent_t<T> *ptr;
 
 public:
+  using element_type = std::remove_extent_t<T>;
+
   WeakPtr() : ctrl(nullptr), ptr(nullptr){};
 
-  WeakPtr(const SharedPtr<T> &sp) {
-    if (sp.ctrl) {
-      sp.ctrl->weak_cnt.fetch_add(1, std::memory_order_release);
-      ctrl = sp.ctrl;
-      ptr = sp.ptr;
+  WeakPtr(const SharedPtr<T, Policy> &sp) : ctrl(sp.ctrl), ptr(sp.ptr) {
+    if (ctrl) {
+      ctrl->add_weak();
     }
   }
-  WeakPtr(const WeakPtr &other) : ctrl(nullptr), ptr(nullptr) {
-    if (other.ctrl) {
-      other.ctrl->weak_cnt.fetch_add(1, std::memory_order_release);
-      ctrl = other.ctrl;
-      ptr = other.ptr;
+  WeakPtr(const WeakPtr &other) : ctrl(other.ctrl), ptr(other.ptr) {
+    if (ctrl) {
+      ctrl->add_weak();
     }
   }
   WeakPtr(WeakPtr &&other) : ctrl(nullptr), ptr(nullptr) {
@@ -172,17 +669,17 @@ public:
     }
   }
   template <typename U>
-  WeakPtr(WeakPtr<U> &other) : ctrl(nullptr), ptr(nullptr) {
+  WeakPtr(WeakPtr<U, Policy> &other) : ctrl(nullptr), ptr(nullptr) {
     if (other.ctrl) {
       ctrl = other.ctrl;
-      ctrl->weak_cnt.fetch_add(1, std::memory_order_release);
+      ctrl->add_weak();
       static_assert(std::is_convertible<U *, T *>::value,
                     "U* must be convertible to T*");
-      ptr = static_cast<T *>(other.ptr);
+      ptr = static_cast<element_type *>(other.ptr);
     }
   }
-  template <typename U> WeakPtr &operator=(WeakPtr<U> &other) {
-    if (this == &other) {
+  template <typename U> WeakPtr &operator=(WeakPtr<U, Policy> &other) {
+    if (static_cast<void *>(this) == static_cast<void *>(&other)) {
       return *this;
     }
     WeakPtr temp(other);
@@ -190,7 +687,7 @@ public:
     return *this;
   }
 
-  WeakPtr &operator=(SharedPtr<T> &other) {
+  WeakPtr &operator=(SharedPtr<T, Policy> &other) {
     WeakPtr temp(other);
     swap(temp);
     return *this;
@@ -201,52 +698,56 @@ public:
     std::swap(ctrl, other.ctrl);
   }
   template <typename U>
-  WeakPtr(WeakPtr<U> &&other) : ctrl(nullptr), ptr(nullptr) {
+  WeakPtr(WeakPtr<U, Policy> &&other) : ctrl(nullptr), ptr(nullptr) {
     if (other.ctrl) {
       static_assert(std::is_convertible<U *, T *>::value,
                     "U* must be convertible to T*");
-      ptr = static_cast<T *>(other.ptr);
+      ptr = static_cast<element_type *>(other.ptr);
       ctrl = other.ctrl;
       other.ptr = nullptr;
       other.ctrl = nullptr;
     }
   }
-  template <typename U> WeakPtr &operator=(WeakPtr<U> &&other) {
-    if (this != &other) {
+  template <typename U> WeakPtr &operator=(WeakPtr<U, Policy> &&other) {
+    if (static_cast<void *>(this) != static_cast<void *>(&other)) {
       release();
-      ptr = static_cast<T *>(other.ptr);
+      ptr = static_cast<element_type *>(other.ptr);
       ctrl = other.ctrl;
       other.ctrl = nullptr;
       other.ptr = nullptr;
     }
     return *this;
   }
-  SharedPtr<T> lock() noexcept {
-    control_block_base *observed_ctrl = ctrl;
-    if (!observed_ctrl) {
-      return SharedPtr<T>();
+  // 与 SharedPtr 的别名构造相同，lock() 得到的 SharedPtr 指向 p
+  template <typename U>
+  WeakPtr(const WeakPtr<U, Policy> &other, element_type *p) noexcept
+      : ctrl(other.ctrl), ptr(p) {
+    if (ctrl) {
+      ctrl->add_weak();
     }
-    int expected_count = observed_ctrl->ref_cnt.load(std::memory_order_acquire);
-    while (true) {
-      if (expected_count == 0) {
-        return SharedPtr<T>();
-      }
-      if (observed_ctrl->ref_cnt.compare_exchange_weak(
-              expected_count, expected_count + 1, std::memory_order_release,
-              std::memory_order_relaxed)) {
-        return SharedPtr<T>(ptr, observed_ctrl);
-      }
+  }
+  template <typename U>
+  WeakPtr(WeakPtr<U, Policy> &&other, element_type *p) noexcept
+      : ctrl(other.ctrl), ptr(p) {
+    other.ctrl = nullptr;
+    other.ptr = nullptr;
+  }
+  // 只读一次强计数，不做 RMW；结果可能立刻过时，只适合用来跳过已经失效的对象
+  bool expired() const noexcept { return !ctrl || ctrl->use_count() == 0; }
+  int use_count() const noexcept { return ctrl ? ctrl->use_count() : 0; }
+  SharedPtr<T, Policy> lock() noexcept {
+    if (ctrl && ctrl->try_add_ref()) {
+      SMART_PTR_COUNT(T, lock_successes);
+      return SharedPtr<T, Policy>(ptr, ctrl);
     }
+    SMART_PTR_COUNT(T, lock_failures);
+    return SharedPtr<T, Policy>();
   }
   void release() {
     if (!ctrl) {
       return;
     }
-    if (ctrl->weak_cnt.fetch_sub(1, std::memory_order_acq_rel) == 1) {
-      if (ctrl->ref_cnt.load() == 0) {
-        delete ctrl;
-      }
-    }
+    ctrl->release_weak();
   }
   WeakPtr &operator=(std::nullptr_t) noexcept {
     release();
@@ -254,10 +755,368 @@ public:
     ctrl = nullptr;
     return *this;
   }
+  // 与 SharedPtr::detach/adopt 相同，转移的是一个弱引用
+  struct handle {
+    element_type *ptr = nullptr;
+    basic_control_block_base<Policy> *ctrl = nullptr;
+  };
+  handle detach() noexcept {
+    handle h{ptr, ctrl};
+    ptr = nullptr;
+    ctrl = nullptr;
+    return h;
+  }
+  static WeakPtr adopt(handle h) noexcept {
+    WeakPtr result;
+    result.ctrl = h.ctrl;
+    result.ptr = h.ptr;
+    return result;
+  }
   explicit operator bool() { return ptr != nullptr; }
   ~WeakPtr() { release(); }
 };
+
+template <typename T> using LocalSharedPtr = SharedPtr<T, local_policy>;
+template <typename T> using LocalWeakPtr = WeakPtr<T, local_policy>;
+
+// 派生类可以从 this 拿到与已有 SharedPtr 共享所有权的指针：
+//   struct Handler : EnableSharedFromThis<Handler> { ... };
+// SharedPtr 的裸指针构造函数与各个 make_shared 在第一次接管对象时填好 weak_this，
+// 不需要单独的初始化步骤；weak_this 就放在对象里，与 make_shared 的对象同一次分配。
+// Policy 必须与接管它的 SharedPtr 相同，否则不会被填写。
+// 对象还没有被任何 SharedPtr 接管 (或正在析构) 时 shared_from_this 返回空指针
+template <typename T, typename Policy = atomic_policy>
+class EnableSharedFromThis {
+public:
+  SharedPtr<T, Policy> shared_from_this() { return weak_this.lock(); }
+  SharedPtr<const T, Policy> shared_from_this() const {
+    return weak_this.lock();
+  }
+  WeakPtr<T, Policy> weak_from_this() noexcept { return weak_this; }
+  WeakPtr<const T, Policy> weak_from_this() const noexcept {
+    return WeakPtr<const T, Policy>(weak_this);
+  }
+
+protected:
+  EnableSharedFromThis() noexcept {}
+  // 拷贝出来的是另一个对象，不继承原对象的 weak_this
+  EnableSharedFromThis(const EnableSharedFromThis &) noexcept {}
+  EnableSharedFromThis &operator=(const EnableSharedFromThis &) noexcept {
+    return *this;
+  }
+  ~EnableSharedFromThis() {}
+
+private:
+  friend struct shared_ptr_access;
+  mutable WeakPtr<T, Policy> weak_this;
+};
+
+// 库内部的工厂函数通过它使用 SharedPtr 的私有构造函数，免得每加一个工厂就多一个 friend
+struct shared_ptr_access {
+  template <typename T, typename Policy>
+  static SharedPtr<T, Policy> make(std::remove_extent_t<T> *p,
+                                   basic_control_block_base<Policy> *c) {
+    SharedPtr<T, Policy> result(p, c);
+    enable_shared_from_this_hook(result, p);
+    return result;
+  }
+  // 由调用方已经计过数的引用重建 SharedPtr，对象不是新接管的，不走 enable_shared_from_this
+  template <typename T, typename Policy>
+  static SharedPtr<T, Policy> share(std::remove_extent_t<T> *p,
+                                    basic_control_block_base<Policy> *c) {
+    return SharedPtr<T, Policy>(p, c);
+  }
+  template <typename T, typename Policy>
+  static std::remove_extent_t<T> *
+  pointer(const SharedPtr<T, Policy> &p) noexcept {
+    return p.ptr;
+  }
+  template <typename T, typename Policy>
+  static std::remove_extent_t<T> *
+  pointer(const WeakPtr<T, Policy> &p) noexcept {
+    return p.ptr;
+  }
+  template <typename T, typename Policy>
+  static basic_control_block_base<Policy> *
+  block(const SharedPtr<T, Policy> &p) noexcept {
+    return p.ctrl;
+  }
+  template <typename T, typename Policy>
+  static basic_control_block_base<Policy> *
+  block(const WeakPtr<T, Policy> &p) noexcept {
+    return p.ctrl;
+  }
+  // 第一次被 SharedPtr 接管时记下 weak_this；已经被接管过且仍然存活则保持不变
+  template <typename T, typename Policy, typename E>
+  static void enable_shared_from_this(
+      const SharedPtr<T, Policy> &p,
+      const EnableSharedFromThis<E, Policy> *base) noexcept {
+    WeakPtr<E, Policy> &weak = base->weak_this;
+    if (weak.ctrl && weak.ctrl->use_count() != 0) {
+      return;
+    }
+    WeakPtr<E, Policy> fresh;
+    fresh.ctrl = p.ctrl;
+    fresh.ptr = const_cast<E *>(static_cast<const E *>(p.ptr));
+    fresh.ctrl->add_weak();
+    weak.swap(fresh);
+  }
+  // 对象不析构而是留作复用时 (ObjectPool 的 reset 回调) 放掉 weak_this 的弱引用，
+  // 否则旧控制块的弱计数永远不归零
+  template <typename E, typename Policy>
+  static void
+  forget_shared_from_this(const EnableSharedFromThis<E, Policy> *base) noexcept {
+    WeakPtr<E, Policy> empty;
+    empty.swap(base->weak_this);
+  }
+  // 置空 p 但不释放它的引用，引用转交给调用方
+  template <typename T, typename Policy>
+  static basic_control_block_base<Policy> *
+  detach(SharedPtr<T, Policy> &p) noexcept {
+    basic_control_block_base<Policy> *c = p.ctrl;
+    p.ptr = nullptr;
+    p.ctrl = nullptr;
+    return c;
+  }
+};
+
+// SharedPtr 接管新对象时调用：派生自 EnableSharedFromThis 的对象选中第一个重载，
+// 其余类型选中什么也不做的第二个 (派生类指针转基类指针优先于转 void*)
+template <typename T, typename Policy, typename E>
+std::enable_if_t<!std::is_array<T>::value> enable_shared_from_this_hook(
+    const SharedPtr<T, Policy> &p,
+    const EnableSharedFromThis<E, Policy> *base) noexcept {
+  if (base) {
+    shared_ptr_access::enable_shared_from_this(p, base);
+  }
+}
+template <typename T, typename Policy>
+void enable_shared_from_this_hook(const SharedPtr<T, Policy> &,
+                                  const volatile void *) noexcept {}
+
+// 同样的重载选择做成类型特征：T 是否派生自某个 EnableSharedFromThis
+template <typename E, typename Policy>
+std::true_type derives_from_enable_shared(
+    const EnableSharedFromThis<E, Policy> *);
+std::false_type derives_from_enable_shared(const volatile void *);
+template <typename T>
+struct is_enable_shared_from_this
+    : decltype(derives_from_enable_shared(std::declval<T *>())) {};
+
+// 同样按重载选择：派生自 EnableSharedFromThis 的对象清空 weak_this，其余什么也不做
+template <typename E, typename Policy>
+void forget_shared_from_this_hook(
+    const EnableSharedFromThis<E, Policy> *base) noexcept {
+  shared_ptr_access::forget_shared_from_this(base);
+}
+inline void forget_shared_from_this_hook(const volatile void *) noexcept {}
+
+// 指针转换，结果与 p 共用控制块，都不分配内存。
+// 左值版本加一次计数；右值版本直接接管 p 的引用，不碰计数
+template <typename T, typename U, typename Policy>
+SharedPtr<T, Policy>
+static_pointer_cast(const SharedPtr<U, Policy> &p) noexcept {
+  using E = std::remove_extent_t<T>;
+  return SharedPtr<T, Policy>(p,
+                              static_cast<E *>(shared_ptr_access::pointer(p)));
+}
+template <typename T, typename U, typename Policy>
+SharedPtr<T, Policy> static_pointer_cast(SharedPtr<U, Policy> &&p) noexcept {
+  using E = std::remove_extent_t<T>;
+  auto *raw = static_cast<E *>(shared_ptr_access::pointer(p));
+  return SharedPtr<T, Policy>(std::move(p), raw);
+}
+template <typename T, typename U, typename Policy>
+SharedPtr<T, Policy>
+const_pointer_cast(const SharedPtr<U, Policy> &p) noexcept {
+  using E = std::remove_extent_t<T>;
+  return SharedPtr<T, Policy>(p,
+                              const_cast<E *>(shared_ptr_access::pointer(p)));
+}
+template <typename T, typename U, typename Policy>
+SharedPtr<T, Policy> const_pointer_cast(SharedPtr<U, Policy> &&p) noexcept {
+  using E = std::remove_extent_t<T>;
+  auto *raw = const_cast<E *>(shared_ptr_access::pointer(p));
+  return SharedPtr<T, Policy>(std::move(p), raw);
+}
+template <typename T, typename U, typename Policy>
+SharedPtr<T, Policy>
+reinterpret_pointer_cast(const SharedPtr<U, Policy> &p) noexcept {
+  using E = std::remove_extent_t<T>;
+  return SharedPtr<T, Policy>(
+      p, reinterpret_cast<E *>(shared_ptr_access::pointer(p)));
+}
+template <typename T, typename U, typename Policy>
+SharedPtr<T, Policy>
+reinterpret_pointer_cast(SharedPtr<U, Policy> &&p) noexcept {
+  using E = std::remove_extent_t<T>;
+  auto *raw = reinterpret_cast<E *>(shared_ptr_access::pointer(p));
+  return SharedPtr<T, Policy>(std::move(p), raw);
+}
+// 转换失败时返回空指针，右值版本此时不会动 p
+template <typename T, typename U, typename Policy>
+SharedPtr<T, Policy>
+dynamic_pointer_cast(const SharedPtr<U, Policy> &p) noexcept {
+  if (T *raw = dynamic_cast<T *>(shared_ptr_access::pointer(p))) {
+    return SharedPtr<T, Policy>(p, raw);
+  }
+  return SharedPtr<T, Policy>();
+}
+template <typename T, typename U, typename Policy>
+SharedPtr<T, Policy> dynamic_pointer_cast(SharedPtr<U, Policy> &&p) noexcept {
+  if (T *raw = dynamic_cast<T *>(shared_ptr_access::pointer(p))) {
+    return SharedPtr<T, Policy>(std::move(p), raw);
+  }
+  return SharedPtr<T, Policy>();
+}
+
+// WeakPtr 只提供不需要访问对象的转换 (dynamic_cast 要求对象还活着，请先 lock)
+template <typename T, typename U, typename Policy>
+WeakPtr<T, Policy> static_pointer_cast(const WeakPtr<U, Policy> &p) noexcept {
+  using E = std::remove_extent_t<T>;
+  return WeakPtr<T, Policy>(p, static_cast<E *>(shared_ptr_access::pointer(p)));
+}
+template <typename T, typename U, typename Policy>
+WeakPtr<T, Policy> static_pointer_cast(WeakPtr<U, Policy> &&p) noexcept {
+  using E = std::remove_extent_t<T>;
+  auto *raw = static_cast<E *>(shared_ptr_access::pointer(p));
+  return WeakPtr<T, Policy>(std::move(p), raw);
+}
+template <typename T, typename U, typename Policy>
+WeakPtr<T, Policy> const_pointer_cast(const WeakPtr<U, Policy> &p) noexcept {
+  using E = std::remove_extent_t<T>;
+  return WeakPtr<T, Policy>(p, const_cast<E *>(shared_ptr_access::pointer(p)));
+}
+template <typename T, typename U, typename Policy>
+WeakPtr<T, Policy> const_pointer_cast(WeakPtr<U, Policy> &&p) noexcept {
+  using E = std::remove_extent_t<T>;
+  auto *raw = const_cast<E *>(shared_ptr_access::pointer(p));
+  return WeakPtr<T, Policy>(std::move(p), raw);
+}
+
+// SharedPtr<T, Policy> 中的 T，供 release_range 按类型插桩计数
+template <typename P> struct shared_ptr_type;
+template <typename T, typename Policy>
+struct shared_ptr_type<SharedPtr<T, Policy>> {
+  using type = T;
+};
+
+// 释放 [first, last) 中的所有 SharedPtr 并把它们置空，同一控制块的引用合并成一次
+// release(n)。用一张很小的表记录最近遇到的控制块，广播后成片相同或少数几个控制块
+// 交替出现的情况都只需常数次原子操作；表满时换出最早的一项
+template <typename ForwardIt>
+void release_range(ForwardIt first, ForwardIt last) noexcept {
+  using pointer_type = typename std::iterator_traits<ForwardIt>::value_type;
+  using block_type =
+      decltype(shared_ptr_access::detach(std::declval<pointer_type &>()));
+  constexpr int table_size = 8;
+  block_type blocks[table_size] = {};
+  int counts[table_size] = {};
+  int used = 0;
+  int victim = 0;
+  for (; first != last; ++first) {
+    block_type ctrl = shared_ptr_access::detach(*first);
+    if (!ctrl) {
+      continue;
+    }
+    int i = 0;
+    while (i < used && blocks[i] != ctrl) {
+      ++i;
+    }
+    if (i == used) {
+      if (used == table_size) {
+        i = victim;
+        victim = (victim + 1) % table_size;
+        SMART_PTR_COUNT_N(typename shared_ptr_type<pointer_type>::type,
+                          releases, counts[i]);
+        blocks[i]->release(counts[i]);
+      } else {
+        ++used;
+      }
+      blocks[i] = ctrl;
+      counts[i] = 0;
+    }
+    ++counts[i];
+  }
+  for (int i = 0; i < used; ++i) {
+    SMART_PTR_COUNT_N(typename shared_ptr_type<pointer_type>::type, releases,
+                      counts[i]);
+    blocks[i]->release(counts[i]);
+  }
+}
+
+template <typename T, typename Policy, typename... Args>
+SharedPtr<T, Policy> basic_make_shared(Args &&...args) {
+  auto *ctrl = new sealed_block<control_block_inplace<T, Policy>>(
+      std::forward<Args>(args)...);
+  return shared_ptr_access::make<T, Policy>(ctrl->get(), ctrl);
+}
+
+template <typename T, typename... Args>
+std::enable_if_t<!std::is_array<T>::value, SharedPtr<T>>
+make_shared(Args &&...args) {
+  return basic_make_shared<T, atomic_policy>(std::forward<Args>(args)...);
+}
+
+// 数组与控制块一次分配，见 control_block_array
+template <typename T, typename Policy>
+SharedPtr<T, Policy> basic_make_shared_array(std::size_t n, bool default_init) {
+  auto *ctrl = control_block_array<std::remove_extent_t<T>, Policy>::create(
+      n, default_init);
+  return shared_ptr_access::make<T, Policy>(ctrl->get(), ctrl);
+}
+
+// make_shared<double[]>(n) / make_shared<double[8]>()：元素值初始化 (清零)
+template <typename T>
+std::enable_if_t<std::is_array<T>::value && std::extent<T>::value == 0,
+                 SharedPtr<T>>
+make_shared(std::size_t n) {
+  return basic_make_shared_array<T, atomic_policy>(n, false);
+}
+template <typename T>
+std::enable_if_t<std::extent<T>::value != 0, SharedPtr<T>> make_shared() {
+  return basic_make_shared_array<T, atomic_policy>(std::extent<T>::value,
+                                                   false);
+}
+
+// 同上但元素默认初始化，平凡类型不清零；用于马上会被整体覆盖的大缓冲区
+template <typename T>
+std::enable_if_t<std::is_array<T>::value && std::extent<T>::value == 0,
+                 SharedPtr<T>>
+make_shared_for_overwrite(std::size_t n) {
+  return basic_make_shared_array<T, atomic_policy>(n, true);
+}
+template <typename T>
+std::enable_if_t<std::extent<T>::value != 0, SharedPtr<T>>
+make_shared_for_overwrite() {
+  return basic_make_shared_array<T, atomic_policy>(std::extent<T>::value, true);
+}
+
 template <typename T, typename... Args>
-SharedPtr<T> make_shared(Args&&... args) {
-    return SharedPtr<T>(new T(std::forward<Args>(args)...));
-};
\ No newline at end of file
+LocalSharedPtr<T> make_local_shared(Args &&...args) {
+  return basic_make_shared<T, local_policy>(std::forward<Args>(args)...);
+}
+
+template <typename T, typename Policy, typename Alloc, typename... Args>
+SharedPtr<T, Policy> basic_allocate_shared(const Alloc &alloc,
+                                           Args &&...args) {
+  using block_type = control_block_alloc<T, Alloc, Policy>;
+  using traits = std::allocator_traits<typename block_type::allocator_type>;
+  typename block_type::allocator_type block_alloc(alloc);
+  block_type *ctrl = traits::allocate(block_alloc, 1);
+  try {
+    ::new (static_cast<void *>(ctrl))
+        block_type(block_alloc, std::forward<Args>(args)...);
+  } catch (...) {
+    traits::deallocate(block_alloc, ctrl, 1);
+    throw;
+  }
+  return shared_ptr_access::make<T, Policy>(ctrl->get(), ctrl);
+}
+
+// 对象与控制块一次性从 alloc 分配，alloc 及其副本需要活到最后一个 WeakPtr 释放
+template <typename T, typename Alloc, typename... Args>
+SharedPtr<T> allocate_shared(const Alloc &alloc, Args &&...args) {
+  return basic_allocate_shared<T, atomic_policy>(alloc,
+                                                 std::forward<Args>(args)...);
+}
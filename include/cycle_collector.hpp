@@ -0,0 +1,512 @@
+#pragma once
+#include "control_.hpp"
+#include <chrono>
+#include <cstddef>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+
+// SharedPtr 引用环的回收器 (试探删除，trial deletion)。只管理经
+// make_collectable 创建、类型提供了 trace 的对象：
+//   struct Node {
+//     SharedPtr<Node> next;
+//     void trace(cycle_tracer &t) { t(next); }
+//   };
+//   cycle_collector gc;
+//   SharedPtr<Node> a = make_collectable<Node>(gc);
+//   a->next = a;          // 自环
+//   a = nullptr;          // 引用计数回收不了
+//   gc.step(1024);        // 每次最多做约 1024 个单位的工作，或 gc.collect()
+//
+// 一轮回收 (与 CPython 的 gc 相同的思路)：
+// 1. 把所有被跟踪的对象移入工作链表，gc_refs = 强计数。
+// 2. 对每个对象 trace 一遍，它引用的被跟踪对象 gc_refs 减 1。
+//    剩下的 gc_refs 就是来自被跟踪对象之外的引用数。
+// 3. gc_refs > 0 的对象以及从它们可达的对象留下，其余暂时移入不可达链表。
+// 4. 不可达的对象各加一个强引用钉住，并按它们之间的引用分组 (并查集)。
+//    然后逐组用此刻的计数对这一组重做 1-3 作为校验：通过的才是垃圾，
+//    摘掉它们之间的 SharedPtr (不减计数) 后把强计数直接清零；
+//    没通过的放掉钉住的引用，回到 tracked。
+// 5. 逐个析构垃圾对象，它指向组外的引用照常释放，WeakPtr 在第 4 步就已失效。
+//
+// 每一步都按链表推进，可以在任意对象之间暂停，step 之间程序可以任意修改对象图：
+// 期间新建的对象留给下一轮，析构的对象直接从链表里摘掉，被修改的引用
+// 最多让 1-3 的结论过时。第 4 步的校验以组为单位在同一次 step 里完成，用的是
+// 最新的计数，不会回收仍被引用的对象；钉住保证分组之后、校验之前组员不会析构。
+// 真正的垃圾组只被组内引用，与图的其余部分无关，所以每次 step 至多比预算多做
+// 一组 (一个相连的不可达子图) 的工作，暂停时间与垃圾总量无关。
+//
+// 限制：
+// - 回收器及其管理的对象 (包括对它们的 SharedPtr 的拷贝与释放) 只能在同一个线程
+//   上使用，或由调用方串行化；计数仍是 atomic_policy，只是为了与 SharedPtr<T> 互通。
+// - trace 必须报告对象持有的每一个 SharedPtr 成员 (只报告被跟踪的也可以)；
+//   漏报只会让环回收不掉，不会回收错对象。
+// - 回收器必须比它管理的对象活得更久；析构时先 collect()，剩下的对象不再被跟踪。
+// - 垃圾一经确认强计数即为 0：lock() 失败、expired() 为 true，哪怕对象要在之后的
+//   step 里才析构；析构函数运行时，对象指向同一组垃圾的 SharedPtr 成员已被置空。
+
+class cycle_collector;
+class cycle_tracer;
+template <typename T> class collectable_block;
+
+// 让不能修改的类型也能被跟踪：特化 cycle_trace<T>
+template <typename T> struct cycle_trace {
+  void operator()(T &object, cycle_tracer &tracer) const {
+    object.trace(tracer);
+  }
+};
+
+// 被跟踪控制块上的侵入式节点，链表带哨兵，不在任何链表里时 next 为 nullptr
+struct cycle_node {
+  cycle_node *prev = nullptr;
+  cycle_node *next = nullptr;
+  cycle_collector *collector = nullptr;
+  control_block_base *block = nullptr;
+  void (*trace)(cycle_node *, cycle_tracer &) = nullptr;
+  cycle_node *group = nullptr; // 第 4 步：并查集的父节点
+  cycle_node *ring = nullptr;  // 第 4 步：同组成员串成的环
+  long gc_refs = 0;
+  unsigned epoch = 0; // 等于回收器当前轮次时才参与这一轮
+  enum : unsigned char {
+    none,
+    unreachable, // 第 3 步的结论
+    grouped,     // 已钉住、已分组，等待校验
+    checking,    // 正在校验的这一组
+    garbage      // 校验通过，等待析构
+  } mark = none;
+};
+
+// 传给 trace 的访问者：对每个 SharedPtr 成员调用一次 tracer(member)
+class cycle_tracer {
+public:
+  template <typename U, typename P> void operator()(SharedPtr<U, P> &child);
+
+private:
+  friend class cycle_collector;
+  enum class mode { subtract, scan, group, clear };
+  cycle_tracer(cycle_collector &c, cycle_node *n, mode m) noexcept
+      : owner(&c), from(n), how(m) {}
+  cycle_collector *owner;
+  cycle_node *from;
+  mode how;
+  std::size_t edges = 0;
+};
+
+class cycle_collector {
+public:
+  cycle_collector() = default;
+  cycle_collector(const cycle_collector &) = delete;
+  cycle_collector &operator=(const cycle_collector &) = delete;
+  ~cycle_collector() {
+    collect();
+    while (!tracked.empty()) {
+      cycle_node *n = tracked.front();
+      list::unlink(n);
+      n->collector = nullptr;
+    }
+  }
+
+  // 做约 budget 个单位的工作 (每个对象 1 个，每条被 trace 的引用 1 个，
+  // 第 4 步的一组校验不拆开，最多超出一组)；
+  // 这次调用里完成了一轮 (或没有可跟踪的对象) 时返回 true
+  bool step(std::size_t budget = 1024) {
+    if (current == phase::idle) {
+      if (tracked.empty()) {
+        return true;
+      }
+      begin_round();
+    }
+    std::size_t done = 0;
+    while (done < budget) {
+      if (current == phase::release) {
+        if (condemned.empty()) {
+          current = phase::idle;
+          return true;
+        }
+        // 析构时由 untrack 摘下并计数
+        condemned.front()->block->release_last();
+        done += 1;
+        continue;
+      }
+      if (cursor == walking->end()) {
+        if (!next_phase()) {
+          return true;
+        }
+        continue;
+      }
+      cycle_node *n = cursor;
+      switch (current) {
+      case phase::count:
+        n->epoch = epoch;
+        n->mark = cycle_node::none;
+        n->gc_refs = n->block->use_count();
+        cursor = n->next;
+        done += 1;
+        break;
+      case phase::subtract:
+        cursor = n->next;
+        done += 1 + trace(n, cycle_tracer::mode::subtract);
+        break;
+      case phase::scan:
+        done += 1 + scan_one(n);
+        break;
+      case phase::group:
+        cursor = n->next;
+        if (n->mark == cycle_node::unreachable) {
+          pin(n);
+        }
+        done += 1 + trace(n, cycle_tracer::mode::group);
+        break;
+      default:
+        done += verify_group(n);
+        break;
+      }
+    }
+    return false;
+  }
+
+  // 以 step 推进，直到完成一轮或用完 slice；返回是否完成了一轮
+  template <typename Rep, typename Period>
+  bool step_for(std::chrono::duration<Rep, Period> slice,
+                std::size_t granularity = 256) {
+    auto deadline = std::chrono::steady_clock::now() + slice;
+    do {
+      if (step(granularity)) {
+        return true;
+      }
+    } while (std::chrono::steady_clock::now() < deadline);
+    return false;
+  }
+
+  // 完成进行中的一轮再完整跑一轮，返回这期间回收的对象数
+  std::size_t collect() {
+    std::size_t before = reclaimed_total;
+    if (current != phase::idle) {
+      while (!step(std::size_t(-1))) {
+      }
+    }
+    while (!step(std::size_t(-1))) {
+    }
+    return reclaimed_total - before;
+  }
+
+  bool in_progress() const noexcept { return current != phase::idle; }
+  std::size_t tracked_count() const noexcept { return tracked_objects; }
+  std::size_t reclaimed() const noexcept { return reclaimed_total; }
+
+private:
+  template <typename> friend class collectable_block;
+  friend class cycle_tracer;
+
+  struct list {
+    cycle_node head;
+    list() noexcept { head.prev = head.next = &head; }
+    list(const list &) = delete;
+    bool empty() const noexcept { return head.next == &head; }
+    cycle_node *front() noexcept { return head.next; }
+    cycle_node *end() noexcept { return &head; }
+    void push_back(cycle_node *n) noexcept {
+      n->prev = head.prev;
+      n->next = &head;
+      head.prev->next = n;
+      head.prev = n;
+    }
+    void splice_back(list &other) noexcept {
+      if (other.empty()) {
+        return;
+      }
+      other.head.next->prev = head.prev;
+      head.prev->next = other.head.next;
+      other.head.prev->next = &head;
+      head.prev = other.head.prev;
+      other.head.prev = other.head.next = &other.head;
+    }
+    static void unlink(cycle_node *n) noexcept {
+      n->prev->next = n->next;
+      n->next->prev = n->prev;
+      n->prev = n->next = nullptr;
+    }
+  };
+
+  enum class phase { idle, count, subtract, scan, group, verify, release };
+
+  void track(cycle_node *n) noexcept {
+    tracked.push_back(n);
+    ++tracked_objects;
+  }
+  // 对象析构时由控制块调用；可能发生在两次 step 之间，也可能在释放垃圾时
+  void untrack(cycle_node *n) noexcept {
+    if (!n->next) {
+      return;
+    }
+    if (n == cursor) {
+      cursor = n->next;
+    }
+    list::unlink(n);
+    --tracked_objects;
+    if (n->mark == cycle_node::garbage) {
+      ++reclaimed_total;
+    }
+  }
+
+  void begin_round() noexcept {
+    if (++epoch == 0) {
+      epoch = 1; // 0 留给尚未参与任何一轮的对象
+    }
+    work.splice_back(tracked);
+    walking = &work;
+    cursor = work.front();
+    current = phase::count;
+  }
+
+  // 当前阶段走完了它的链表；返回 false 表示这一轮已经结束
+  bool next_phase() noexcept {
+    switch (current) {
+    case phase::count:
+      current = phase::subtract;
+      member_mark = cycle_node::none;
+      break;
+    case phase::subtract:
+      current = phase::scan;
+      scan_from = &work;
+      scan_to = &unreachable;
+      member_mark = cycle_node::none;
+      out_mark = cycle_node::unreachable;
+      break;
+    case phase::scan:
+      tracked.splice_back(work);
+      if (unreachable.empty()) {
+        current = phase::idle;
+        return false;
+      }
+      current = phase::group;
+      walking = &unreachable;
+      break;
+    case phase::group:
+      current = phase::verify;
+      break;
+    default:
+      current = condemned.empty() ? phase::idle : phase::release;
+      return current != phase::idle;
+    }
+    cursor = walking->front();
+    return true;
+  }
+
+  std::size_t trace(cycle_node *n, cycle_tracer::mode how) {
+    cycle_tracer tracer(*this, n, how);
+    n->trace(n, tracer);
+    return tracer.edges;
+  }
+
+  // 第 3 步的一次推进：gc_refs > 0 的对象可达，它引用的对象随之可达
+  // (已经移出去的移回 scan_from 末尾，稍后再扫描)；否则暂时移入 scan_to
+  std::size_t scan_one(cycle_node *n) {
+    if (n->gc_refs > 0) {
+      std::size_t edges = trace(n, cycle_tracer::mode::scan);
+      cursor = n->next; // trace 可能刚把对象追加在 n 后面
+      return edges;
+    }
+    cursor = n->next;
+    list::unlink(n);
+    scan_to->push_back(n);
+    n->mark = out_mark;
+    return 0;
+  }
+
+  // 由 cycle_tracer 对 from 引用的、属于本轮的 child 调用；
+  // 返回 true 表示应摘掉这个引用
+  bool visit(cycle_node *from, cycle_node *child,
+             cycle_tracer::mode how) noexcept {
+    switch (how) {
+    case cycle_tracer::mode::subtract:
+      if (child->mark == member_mark) {
+        --child->gc_refs;
+      }
+      return false;
+    case cycle_tracer::mode::scan:
+      if (child->mark == out_mark) {
+        list::unlink(child);
+        scan_from->push_back(child);
+        child->mark = member_mark;
+        child->gc_refs = 1;
+      } else if (child->mark == member_mark && child->gc_refs <= 0) {
+        child->gc_refs = 1;
+      }
+      return false;
+    case cycle_tracer::mode::group:
+      if (child->mark == cycle_node::unreachable) {
+        pin(child);
+      }
+      if (child->mark == cycle_node::grouped) {
+        unite(from, child);
+      }
+      return false;
+    default:
+      return child->mark == cycle_node::garbage;
+    }
+  }
+
+  // 第 4 步的分组：钉住的引用保证组员在校验之前不会析构，
+  // 并查集的指针因此一直有效
+  void pin(cycle_node *n) noexcept {
+    n->block->add_ref();
+    n->mark = cycle_node::grouped;
+    n->group = n->ring = n;
+  }
+  static cycle_node *find(cycle_node *n) noexcept {
+    while (n->group != n) {
+      n->group = n->group->group;
+      n = n->group;
+    }
+    return n;
+  }
+  static void unite(cycle_node *a, cycle_node *b) noexcept {
+    a = find(a);
+    b = find(b);
+    if (a != b) {
+      b->group = a;
+      std::swap(a->ring, b->ring); // 两个环接成一个
+    }
+  }
+
+  // 第 4 步的校验：在这一次调用里用此刻的计数对 n 所在的组重做 1-3。
+  // 垃圾摘掉彼此之间的引用 (不减计数)，强计数清零后移入 condemned，
+  // 从此 lock() 失败；其余对象放掉钉住的引用回到 tracked。
+  // 返回做了多少个单位的工作
+  std::size_t verify_group(cycle_node *n) {
+    std::size_t done = 0;
+    list members;
+    cycle_node *root = find(n);
+    cycle_node *m = root;
+    do {
+      cycle_node *next = m->ring;
+      if (m == cursor) {
+        cursor = m->next;
+      }
+      list::unlink(m);
+      members.push_back(m);
+      m->mark = cycle_node::checking;
+      m->gc_refs = m->block->use_count() - 1; // 不算钉住的引用
+      ++done;
+      m = next;
+    } while (m != root);
+    member_mark = cycle_node::checking;
+    for (m = members.front(); m != members.end(); m = m->next) {
+      done += trace(m, cycle_tracer::mode::subtract);
+    }
+    list garbage;
+    cycle_node *resume = cursor;
+    scan_from = &members;
+    scan_to = &garbage;
+    out_mark = cycle_node::garbage;
+    cursor = members.front();
+    while (cursor != members.end()) {
+      done += 1 + scan_one(cursor);
+    }
+    cursor = resume;
+    // 先让垃圾的 lock() 失败，再放掉其余组员：放掉可能析构对象，
+    // 析构函数里的 lock() 不能取回垃圾
+    for (m = garbage.front(); m != garbage.end(); m = m->next) {
+      done += 1 + trace(m, cycle_tracer::mode::clear);
+      atomic_policy::subtract(m->block->ref_cnt, m->block->use_count());
+    }
+    condemned.splice_back(garbage);
+    while (!members.empty()) {
+      m = members.front();
+      list::unlink(m);
+      m->mark = cycle_node::none;
+      tracked.push_back(m);
+      m->block->release();
+      ++done;
+    }
+    return done;
+  }
+
+  list tracked; // 不在进行中的这一轮里的对象，包括这一轮开始后新建的
+  list work;
+  list unreachable;
+  list condemned; // 校验通过、强计数已清零、等待析构的垃圾
+  list *walking = &work; // cursor 所在的链表
+  cycle_node *cursor = nullptr;
+  phase current = phase::idle;
+  unsigned epoch = 0;
+  list *scan_from = nullptr;
+  list *scan_to = nullptr;
+  decltype(cycle_node::mark) member_mark = cycle_node::none;
+  decltype(cycle_node::mark) out_mark = cycle_node::unreachable;
+  std::size_t tracked_objects = 0;
+  std::size_t reclaimed_total = 0;
+};
+
+// make_collectable 分配的控制块：对象原地构造，创建时登记到回收器，
+// 对象析构时摘下
+template <typename T>
+class collectable_block final : public control_block_inplace<T>,
+                                public cycle_node {
+public:
+  template <typename... Args>
+  explicit collectable_block(cycle_collector &c, Args &&...args)
+      : control_block_inplace<T>(std::forward<Args>(args)...) {
+    collector = &c;
+    block = this;
+    trace = &trace_object;
+    c.track(this);
+  }
+  void delete_ptr() override {
+    if (collector) {
+      collector->untrack(this);
+    }
+    control_block_inplace<T>::delete_ptr();
+  }
+  void release_last() noexcept override {
+    delete_ptr();
+    if (this->drop_weak()) {
+      delete this;
+    }
+  }
+  void destroy() noexcept override { delete this; }
+
+private:
+  static void trace_object(cycle_node *n, cycle_tracer &tracer) {
+    cycle_trace<T>()(*static_cast<collectable_block *>(n)->get(), tracer);
+  }
+};
+
+// 只有 atomic_policy 的 SharedPtr 可能指向被跟踪的控制块
+template <typename U, typename P>
+void cycle_tracer::operator()(SharedPtr<U, P> &child) {
+  if constexpr (std::is_same<P, atomic_policy>::value) {
+    control_block_base *block = shared_ptr_access::block(child);
+    if (!block) {
+      return;
+    }
+    ++edges;
+    // 常见情况是 child 的类型就是被跟踪对象的类型，先比较一次 typeid；
+    // 经过基类指针引用的再用 dynamic_cast 交叉转换
+    using exact = collectable_block<std::remove_cv_t<U>>;
+    cycle_node *n = nullptr;
+    if constexpr (!std::is_array<U>::value && !std::is_abstract<U>::value) {
+      if (typeid(*block) == typeid(exact)) {
+        n = static_cast<exact *>(block);
+      }
+    }
+    if (!n) {
+      n = dynamic_cast<cycle_node *>(block);
+    }
+    // 摘掉的引用不减计数，它计在 child 的强计数里，由校验之后的清零一并抹掉
+    if (n && n->collector == owner && n->epoch == owner->epoch &&
+        n->next && owner->visit(from, n, how)) {
+      shared_ptr_access::detach(child);
+    }
+  }
+}
+
+// 对象与控制块一次分配，由 collector 跟踪。作为环状垃圾回收时，lock() 从确认
+// 为垃圾的那次 step 起失败；析构函数里指向同组垃圾的 SharedPtr 成员已为空
+template <typename T, typename... Args>
+SharedPtr<T> make_collectable(cycle_collector &collector, Args &&...args) {
+  auto *ctrl =
+      new collectable_block<T>(collector, std::forward<Args>(args)...);
+  return shared_ptr_access::make<T, atomic_policy>(ctrl->get(), ctrl);
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include "control_.hpp"
+#include <utility>
+
+// 延迟析构的控制块混入，reclaim_queue 与 epoch_domain 共用：
+// 最后一个强引用离开时不直接 delete_ptr，而是把控制块作为节点交给 Sink，
+// 由 Sink 稍后回调析构。期间 lock() 已经失败；额外持有一个弱引用，
+// 保证控制块 (及 make_shared 的对象内存) 在析构之前不被释放。
+//
+// Sink 在自己的头文件里特化 deferred_sink：
+//   template <> struct deferred_sink<my_sink> {
+//     using node_type = my_node;   // 混入控制块的侵入式节点
+//     static void defer(my_sink &, my_node *, void (*reclaim)(my_node *));
+//   };
+template <typename Sink> struct deferred_sink;
+
+template <typename Block, typename Sink>
+class deferred_block : public Block,
+                       private deferred_sink<Sink>::node_type {
+  using node_type = typename deferred_sink<Sink>::node_type;
+
+public:
+  template <typename... Args>
+  explicit deferred_block(Sink &s, Args &&...args)
+      : Block(std::forward<Args>(args)...), sink(&s) {}
+  void delete_ptr() override {
+    this->add_weak();
+    deferred_sink<Sink>::defer(*sink, static_cast<node_type *>(this),
+                               &reclaim);
+  }
+
+private:
+  static void reclaim(node_type *node) {
+    auto *self = static_cast<deferred_block *>(node);
+    self->Block::delete_ptr();
+    self->release_weak();
+  }
+  Sink *sink;
+};
+
+// 对象与控制块一次分配，析构交给 sink
+template <typename T, typename Sink, typename... Args>
+SharedPtr<T> basic_make_deferred_shared(Sink &sink, Args &&...args) {
+  auto *ctrl = new deferred_block<control_block_inplace<T>, Sink>(
+      sink, std::forward<Args>(args)...);
+  return shared_ptr_access::make<T, atomic_policy>(ctrl->get(), ctrl);
+}
+
+// 接管已有的裸指针，最终在 sink 回调时用 delete 释放
+template <typename T, typename Sink>
+SharedPtr<T> basic_deferred_shared(Sink &sink, T *p) {
+  deferred_block<control_block<T>, Sink> *ctrl = nullptr;
+  try {
+    ctrl = new deferred_block<control_block<T>, Sink>(sink, p);
+  } catch (...) {
+    delete p;
+    throw;
+  }
+  return shared_ptr_access::make<T, atomic_policy>(p, ctrl);
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <type_traits>
+#include <utility>
+
+// 空基类优化 (EBO)：无状态的 D (默认 delete、无捕获 lambda) 作为基类存放，不占空间；
+// 有状态或 final 的 D 退化为普通成员。
+template <typename D,
+          bool = std::is_empty<D>::value && !std::is_final<D>::value>
+class ebo_storage : private D {
+public:
+  ebo_storage() = default;
+  template <typename U, typename = std::enable_if_t<!std::is_same<
+                            std::decay_t<U>, ebo_storage>::value>>
+  explicit ebo_storage(U &&u) : D(std::forward<U>(u)) {}
+  D &get() noexcept { return *this; }
+  const D &get() const noexcept { return *this; }
+};
+
+template <typename D> class ebo_storage<D, false> {
+  D value;
+
+public:
+  ebo_storage() = default;
+  template <typename U, typename = std::enable_if_t<!std::is_same<
+                            std::decay_t<U>, ebo_storage>::value>>
+  explicit ebo_storage(U &&u) : value(std::forward<U>(u)) {}
+  D &get() noexcept { return value; }
+  const D &get() const noexcept { return value; }
+};
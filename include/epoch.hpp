@@ -0,0 +1,306 @@
+#pragma once
+#include "control_.hpp"
+#include "deferred_block.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// 基于 epoch 的延迟回收：读者用 epoch_guard 进入临界区后就可以安全地读
+// 发布出来的裸指针，不需要碰对象的引用计数；写者把摘下来的对象 retire 给 domain，
+// 等所有在它之前进入的读者都离开后才真正释放。
+//
+// 算法 (经典 EBR)：全局 epoch E 单调递增；读者进入时把自己的记录设为当前 E，
+// 离开时清 0。只有当所有活跃读者的记录都等于 E 时 E 才能加 1。
+// 在 epoch e 被 retire 的对象，等 E >= e + 2 时已经没有读者可能持有它。
+//
+// 每个线程在每个 domain 中有一条记录 (读者 epoch + 本线程 retire 的待回收链表)，
+// 线程退出时记录交还 domain 复用，未回收的对象转入公共链表由其他线程回收。
+// domain 必须比所有用过它的线程活得更久，通常定义为全局/静态对象，
+// 或直接使用 default_epoch_domain()。
+
+// 可被 retire 的对象的侵入式链表节点；retire 本身因此不需要分配内存
+struct epoch_node {
+  epoch_node *next = nullptr;
+  void (*reclaim)(epoch_node *) = nullptr;
+  std::uint64_t epoch = 0;
+};
+
+class epoch_domain {
+public:
+  epoch_domain() = default;
+  epoch_domain(const epoch_domain &) = delete;
+  epoch_domain &operator=(const epoch_domain &) = delete;
+  // 析构时不应再有读者，剩下的对象全部立刻回收
+  ~epoch_domain() {
+    reclaim_all(take_orphans());
+    for (record *r = records_head.load(std::memory_order_relaxed); r;) {
+      record *next = r->next;
+      reclaim_all(r->retired);
+      delete r;
+      r = next;
+    }
+  }
+
+  // 可嵌套；同一线程在同一 domain 里只有最外层的 enter/leave 生效
+  void enter() {
+    record *r = local_record();
+    if (r->nesting++ == 0) {
+      r->epoch.store(global_epoch.load(std::memory_order_relaxed),
+                     std::memory_order_release);
+      // 先公开自己的 epoch，再读共享数据；与 try_advance 中的 fence 配对
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+  }
+  void leave() noexcept {
+    record *r = cached_record();
+    if (--r->nesting == 0) {
+      r->epoch.store(0, std::memory_order_release);
+    }
+  }
+
+  // 节点在两个 epoch 之后由 reclaim 回调释放
+  void retire(epoch_node *node, void (*reclaim)(epoch_node *)) {
+    record *r = local_record();
+    node->reclaim = reclaim;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    node->epoch = global_epoch.load(std::memory_order_relaxed);
+    node->next = r->retired;
+    r->retired = node;
+    if (++r->retired_count >= r->collect_threshold) {
+      collect(r);
+    }
+  }
+  template <typename T> void retire(T *p) {
+    struct holder : epoch_node {
+      T *object;
+    };
+    auto *node = new holder;
+    node->object = p;
+    retire(node, [](epoch_node *n) {
+      auto *h = static_cast<holder *>(n);
+      delete h->object;
+      delete h;
+    });
+  }
+
+  // 尝试推进 epoch 并回收本线程已经安全的对象，不会阻塞
+  void collect() { collect(local_record()); }
+  // 反复 collect 直到本线程 (以及已退出线程) retire 的对象全部回收。
+  // 只会等待仍在临界区里的读者，不能在 epoch_guard 内调用
+  void drain() {
+    record *r = local_record();
+    while (r->retired || orphan_count.load(std::memory_order_relaxed) != 0) {
+      collect(r);
+      if (r->retired) {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+  std::uint64_t epoch() const noexcept {
+    return global_epoch.load(std::memory_order_relaxed);
+  }
+  // 本线程尚未回收的对象数
+  std::size_t pending() { return local_record()->retired_count; }
+
+private:
+  static constexpr std::size_t min_collect_threshold = 64;
+
+  struct alignas(64) record {
+    std::atomic<std::uint64_t> epoch{0}; // 0 表示不在临界区
+    std::atomic<bool> in_use{true};
+    int nesting = 0;
+    epoch_node *retired = nullptr;
+    std::size_t retired_count = 0;
+    std::size_t collect_threshold = min_collect_threshold;
+    record *next = nullptr;
+  };
+
+  // 线程退出时把本线程在各个 domain 中的记录交还
+  struct thread_records {
+    std::vector<std::pair<epoch_domain *, record *>> entries;
+    ~thread_records() {
+      for (auto &entry : entries) {
+        entry.first->release_record(entry.second);
+      }
+    }
+  };
+  static thread_records &local_records() {
+    static thread_local thread_records records;
+    return records;
+  }
+
+  record *local_record() {
+    for (auto &entry : local_records().entries) {
+      if (entry.first == this) {
+        return entry.second;
+      }
+    }
+    record *r = acquire_record();
+    local_records().entries.emplace_back(this, r);
+    return r;
+  }
+  // leave 只能跟在同一线程的 enter 之后，记录一定已经存在
+  record *cached_record() noexcept {
+    for (auto &entry : local_records().entries) {
+      if (entry.first == this) {
+        return entry.second;
+      }
+    }
+    return nullptr;
+  }
+
+  record *acquire_record() {
+    std::lock_guard<std::mutex> lock(records_mutex);
+    record *head = records_head.load(std::memory_order_relaxed);
+    for (record *r = head; r; r = r->next) {
+      if (!r->in_use.load(std::memory_order_relaxed)) {
+        r->in_use.store(true, std::memory_order_relaxed);
+        return r;
+      }
+    }
+    auto *r = new record;
+    r->next = head;
+    // 记录只增不删，try_advance 可以不加锁遍历
+    records_head.store(r, std::memory_order_release);
+    return r;
+  }
+  void release_record(record *r) {
+    if (r->retired) {
+      std::lock_guard<std::mutex> lock(orphans_mutex);
+      epoch_node *tail = r->retired;
+      while (tail->next) {
+        tail = tail->next;
+      }
+      tail->next = orphans;
+      orphans = r->retired;
+      orphan_count.fetch_add(r->retired_count, std::memory_order_relaxed);
+      r->retired = nullptr;
+      r->retired_count = 0;
+    }
+    r->collect_threshold = min_collect_threshold;
+    std::lock_guard<std::mutex> lock(records_mutex);
+    r->in_use.store(false, std::memory_order_relaxed);
+  }
+
+  epoch_node *take_orphans() {
+    std::lock_guard<std::mutex> lock(orphans_mutex);
+    epoch_node *list = orphans;
+    orphans = nullptr;
+    orphan_count.store(0, std::memory_order_relaxed);
+    return list;
+  }
+
+  // 所有活跃读者都已观察到当前 epoch 时把它加 1，返回推进后的 epoch
+  std::uint64_t try_advance() {
+    std::uint64_t current = global_epoch.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    for (record *r = records_head.load(std::memory_order_acquire); r;
+         r = r->next) {
+      // acquire 与读者 enter/leave 的 release 配对：读者上一次临界区内的读取
+      // 先于这里之后的回收 (fence 之外再显式给出，ThreadSanitizer 不理解 fence)
+      std::uint64_t e = r->epoch.load(std::memory_order_acquire);
+      if (e != 0 && e != current) {
+        return current;
+      }
+    }
+    if (global_epoch.compare_exchange_strong(current, current + 1,
+                                             std::memory_order_acq_rel)) {
+      return current + 1;
+    }
+    return current; // 被其他线程抢先推进，current 已更新
+  }
+
+  void collect(record *r) {
+    if (orphan_count.load(std::memory_order_relaxed) != 0) {
+      std::size_t count = 0;
+      epoch_node *list = take_orphans();
+      for (epoch_node *n = list; n; n = n->next) {
+        ++count;
+        if (!n->next) {
+          n->next = r->retired;
+          r->retired = list;
+          break;
+        }
+      }
+      r->retired_count += count;
+    }
+    std::uint64_t now = try_advance();
+    std::atomic_thread_fence(std::memory_order_acquire);
+    epoch_node **link = &r->retired;
+    epoch_node *ready = nullptr;
+    while (epoch_node *n = *link) {
+      if (n->epoch + 2 <= now) {
+        *link = n->next;
+        n->next = ready;
+        ready = n;
+        --r->retired_count;
+      } else {
+        link = &n->next;
+      }
+    }
+    // 回收回调里可能再次 retire，先把链表摘干净再调用
+    reclaim_all(ready);
+    r->collect_threshold =
+        std::max(min_collect_threshold, 2 * r->retired_count);
+  }
+
+  static void reclaim_all(epoch_node *list) {
+    while (list) {
+      epoch_node *next = list->next;
+      list->reclaim(list);
+      list = next;
+    }
+  }
+
+  std::atomic<std::uint64_t> global_epoch{1};
+  std::atomic<record *> records_head{nullptr};
+  std::mutex records_mutex; // 串行化记录的分配与复用
+  std::mutex orphans_mutex;
+  epoch_node *orphans = nullptr;
+  std::atomic<std::size_t> orphan_count{0};
+};
+
+inline epoch_domain &default_epoch_domain() {
+  static epoch_domain domain;
+  return domain;
+}
+
+// RAII 读者临界区
+class epoch_guard {
+public:
+  explicit epoch_guard(epoch_domain &d = default_epoch_domain()) : domain(d) {
+    domain.enter();
+  }
+  epoch_guard(const epoch_guard &) = delete;
+  epoch_guard &operator=(const epoch_guard &) = delete;
+  ~epoch_guard() { domain.leave(); }
+
+private:
+  epoch_domain &domain;
+};
+
+// 控制块交给 domain retire，析构推迟到所有读者离开之后；
+// 期间 lock() 已经失败，但读者手里的裸指针仍然有效
+template <> struct deferred_sink<epoch_domain> {
+  using node_type = epoch_node;
+  static void defer(epoch_domain &domain, epoch_node *node,
+                    void (*reclaim)(epoch_node *)) {
+    domain.retire(node, reclaim);
+  }
+};
+
+// 对象与控制块一次分配，析构推迟到读者离开之后
+template <typename T, typename... Args>
+SharedPtr<T> make_epoch_shared(epoch_domain &domain, Args &&...args) {
+  return basic_make_deferred_shared<T>(domain, std::forward<Args>(args)...);
+}
+
+// 接管已有的裸指针，最终用 delete 释放
+template <typename T> SharedPtr<T> epoch_shared(epoch_domain &domain, T *p) {
+  return basic_deferred_shared(domain, p);
+}
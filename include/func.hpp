@@ -9,38 +9,187 @@
 #include <new>         // placement new (SBO)
 #include <type_traits> // 需要大量类型萃取工具
 #include <utility>     // std::move, std::forward, std::swap
+
+#include "instrument.hpp" // SMART_PTR_COUNT: 定义 SMART_PTR_INSTRUMENT 时统计内联/堆存储
+
+// 内联缓冲区大小 (字节)，默认约 3 个指针；可在包含本头文件之前重新定义
+#ifndef MYSTD_FUNCTION_BUFFER_SIZE
+#define MYSTD_FUNCTION_BUFFER_SIZE (3 * sizeof(void *))
+#endif
+
 namespace mystd {
 
 using std::bad_function_call;
 template <typename Signature> class function;
+template <typename Signature> class unique_function;
+template <typename Signature> class function_ref;
 
-// 核心实现：针对函数签名 R(Args...) 的特化版本
-template <typename R, typename... Args> class function<R(Args...)> {
-private:
-  // 核心思想：类型擦除 (Type Erasure)
-  // function 需要能存储任意类型的可调用对象 (函数指针、Lambda、函数对象等)，
-  // 只要它们的调用签名与 R(Args...) 兼容即可。
-  // 这通常通过一个内部的抽象基类和派生类模板实现，或者通过函数指针表和缓冲区实现。
-  struct function_base {
-    virtual ~function_base() = default;
-    virtual std::unique_ptr<function_base> clone() const = 0;
-    virtual R invoke(Args... args) const = 0;
-  };
+namespace detail {
+
+// 每个被擦除类型的管理函数表，function 与 unique_function 共用同一种表
+struct function_vtable {
+  void (*copy)(const void *src, void *dst); // 只移动的包装里为 nullptr
+  // 移动构造到 dst 并销毁 src
+  void (*move)(void *src, void *dst) noexcept;
+  void (*destroy)(void *storage) noexcept;
+};
+
+// function 与 unique_function 共用的存储与分发机制，Copyable 决定是否需要拷贝入口。
+//
+// 核心思想：类型擦除 (Type Erasure)
+// function 需要能存储任意类型的可调用对象 (函数指针、Lambda、函数对象等)，
+// 只要它们的调用签名与 R(Args...) 兼容即可。
+// 这通常通过一个内部的抽象基类和派生类模板实现，或者通过函数指针表和缓冲区实现。
+// 不使用虚函数：每个被擦除的类型 F 生成一张静态的管理函数表 (拷贝/移动/析构)，
+// 调用入口 invoke_ 则直接放在对象里，一次调用只是一次间接跳转，
+// 不需要先读 vptr 再读虚表槽位。
+template <bool Copyable, typename R, typename... Args> class function_impl {
+protected:
+  template <bool, typename, typename...> friend class function_impl;
+  template <typename> friend class mystd::function_ref;
+
+  // 小缓冲区优化 (SBO)：放得下且移动不抛异常的可调用对象直接构造在 storage_ 里，
+  // 其余的放在堆上，storage_ 里只存指向它的指针。移动必须 noexcept，
+  // 否则 function 的移动无法保证 noexcept。
+  static constexpr std::size_t buffer_size = MYSTD_FUNCTION_BUFFER_SIZE;
+  // 按指针对齐，避免缓冲区被向上取整；对齐要求更高的类型放到堆上
+  using storage_type = std::aligned_storage_t<
+      (buffer_size < sizeof(void *) ? sizeof(void *) : buffer_size),
+      alignof(void *)>;
+
+  template <typename F>
+  static constexpr bool stored_inline =
+      sizeof(F) <= sizeof(storage_type) &&
+      alignof(F) <= alignof(storage_type) &&
+      std::is_nothrow_move_constructible_v<F>;
+
+  using invoker_type = R (*)(void *, Args &&...);
+  using vtable = function_vtable;
 
   // F是被擦除的类型
-  template <typename F> struct function_derived : function_base {
-    F callable;
-    explicit function_derived(const F &f) : callable(f) {}
-    explicit function_derived(F &&f) : callable(std::move(f)) {}
-    std::unique_ptr<function_base> clone() const override {
-      return std::make_unique<function_derived<F>>(callable);
+  template <typename F, bool Inline = stored_inline<F>> struct handler {
+    static F *get(void *storage) noexcept {
+      if constexpr (Inline) {
+        return std::launder(static_cast<F *>(storage));
+      } else {
+        return *static_cast<F **>(storage);
+      }
     }
-    R invoke(Args... args) const override {
-      return std::invoke(callable, std::forward<Args>(args)...);
+    static const F *get(const void *storage) noexcept {
+      return get(const_cast<void *>(storage));
     }
+    template <typename... Ts> static void create(void *storage, Ts &&...ts) {
+      if constexpr (Inline) {
+        ::new (storage) F(std::forward<Ts>(ts)...);
+        SMART_PTR_COUNT(F, function_inline);
+      } else {
+        *static_cast<F **>(storage) = new F(std::forward<Ts>(ts)...);
+        SMART_PTR_COUNT(F, function_heap);
+      }
+    }
+    static R invoke(void *storage, Args &&...args) {
+      if constexpr (std::is_void_v<R>) {
+        std::invoke(*get(storage), std::forward<Args>(args)...);
+      } else {
+        return std::invoke(*get(storage), std::forward<Args>(args)...);
+      }
+    }
+    static void copy(const void *src, void *dst) { create(dst, *get(src)); }
+    static void move(void *src, void *dst) noexcept {
+      if constexpr (Inline) {
+        ::new (dst) F(std::move(*get(src)));
+        get(src)->~F();
+      } else {
+        *static_cast<F **>(dst) = get(src);
+      }
+    }
+    static void destroy(void *storage) noexcept {
+      if constexpr (Inline) {
+        get(storage)->~F();
+      } else {
+        delete get(storage);
+      }
+    }
+    // 只移动的包装不实例化 copy，因此能存放 unique_ptr 之类只能移动的对象
+    static constexpr auto copy_entry() noexcept {
+      if constexpr (Copyable) {
+        return &copy;
+      } else {
+        return static_cast<void (*)(const void *, void *)>(nullptr);
+      }
+    }
+    static constexpr vtable table{copy_entry(), &move, &destroy};
   };
 
-  std::unique_ptr<function_base> base_ptr_;
+  // 空 function 的调用入口：operator() 因此不需要额外判空
+  static R empty_invoke(void *, Args &&...) { throw bad_function_call(); }
+
+  mutable storage_type storage_;
+  invoker_type invoke_;
+  const vtable *vtable_; // 为空时是 nullptr
+
+  function_impl() noexcept : invoke_(&empty_invoke), vtable_(nullptr) {}
+  function_impl(const function_impl &) = delete;
+  function_impl &operator=(const function_impl &) = delete;
+  ~function_impl() { reset(); }
+
+  template <typename F> void emplace(F &&f) {
+    using Handler = handler<std::decay_t<F>>;
+    Handler::create(&storage_, std::forward<F>(f));
+    invoke_ = &Handler::invoke;
+    vtable_ = &Handler::table;
+  }
+  // 要求 *this 为空
+  void copy_from(const function_impl &other) {
+    if (other.vtable_) {
+      other.vtable_->copy(&other.storage_, &storage_);
+      invoke_ = other.invoke_;
+      vtable_ = other.vtable_;
+    }
+  }
+  // 要求 *this 为空，接管 other 的对象并把 other 置空。
+  // 两种包装的存储布局相同，unique_function 因此可以直接接管 function 的对象。
+  template <bool OtherCopyable>
+  void move_from(function_impl<OtherCopyable, R, Args...> &other) noexcept {
+    if (other.vtable_) {
+      other.vtable_->move(&other.storage_, &storage_);
+      invoke_ = other.invoke_;
+      vtable_ = other.vtable_;
+      other.invoke_ = &other.empty_invoke;
+      other.vtable_ = nullptr;
+    }
+  }
+  void reset() noexcept {
+    if (vtable_) {
+      vtable_->destroy(&storage_);
+      invoke_ = &empty_invoke;
+      vtable_ = nullptr;
+    }
+  }
+  void swap_impl(function_impl &other) noexcept {
+    if (this == &other) {
+      return;
+    }
+    function_impl temp;
+    temp.move_from(other);
+    other.move_from(*this);
+    move_from(temp);
+  }
+  bool empty() const noexcept { return vtable_ == nullptr; }
+  R call(Args &&...args) const {
+    return invoke_(&storage_, std::forward<Args>(args)...);
+  }
+};
+
+} // namespace detail
+
+// 核心实现：针对函数签名 R(Args...) 的特化版本
+template <typename R, typename... Args>
+class function<R(Args...)> : private detail::function_impl<true, R, Args...> {
+private:
+  using impl = detail::function_impl<true, R, Args...>;
+  template <typename> friend class unique_function;
+  template <typename> friend class function_ref;
 
   // --- (用于构造函数和赋值运算符) ---
   // 检查类型 F 是否可以用来构造 function<R(Args...)>
@@ -49,58 +198,51 @@ private:
       // 1. F 不是 function 类型本身
       !std::is_same_v<std::decay_t<F>, function> &&
       // 2. F 必须是可调用的，且其结果可以转换/返回为 R
-      std::is_invocable_r_v<R, F, Args...> // 移除了 F&
-      >;
+      // (与 std::function 一样以非 const 左值调用被存储的对象)
+      std::is_invocable_r_v<R, std::decay_t<F> &, Args...>>;
 
 public:
   using result_type = R;
   // --- 构造函数 ---
   // 1. 默认构造函数: 创建一个空的 function 对象
-  function() noexcept : base_ptr_(nullptr) {}
+  function() noexcept = default;
   // 2. 空指针构造函数: 创建一个空的 function 对象
   function(std::nullptr_t) noexcept : function() {}
   // 3. 拷贝构造函数：如果 other 非空，则克隆 other 内部存储的对象。
-  function(const function &other) {
-    if (other.base_ptr_) {
-      base_ptr_ = other.base_ptr_->clone();
-    }
-  }
+  function(const function &other) : function() { this->copy_from(other); }
 
-  // 4. 移动构造函数
-  function(function &&other) noexcept {
-    base_ptr_ = std::move(other.base_ptr_);
-    other.base_ptr_ = nullptr;
-  }
+  // 4. 移动构造函数：堆上的对象只转移指针，内联的对象移动到自己的缓冲区
+  function(function &&other) noexcept : function() { this->move_from(other); }
 
   // 5. 模板构造函数: 从任意可调用对象 f 构造
-  template <typename F, typename = enable_if_callable<F>> function(F &&f) {
-    using CleanF = std::decay_t<F>;
-    base_ptr_ = std::make_unique<function_derived<CleanF>>(std::forward<F>(f));
+  template <typename F, typename = enable_if_callable<F>>
+  function(F &&f) : function() {
+    this->emplace(std::forward<F>(f));
   }
 
   // --- 析构函数 ---
-  ~function() {
-    // unique_ptr 会自动管理 function_base 的生命周期。
-  }
-
+  ~function() = default;
 
   // --- 赋值运算符 ---
 
   // 1. 拷贝赋值运算符
   function &operator=(const function &other) {
     function(other).swap(*this);
-    return *this; // Placeholder
+    return *this;
   }
 
   // 2. 移动赋值运算符
   function &operator=(function &&other) noexcept {
-    function(std::move(other)).swap(*this);
+    if (this != &other) {
+      this->reset();
+      this->move_from(other);
+    }
     return *this;
   }
 
   // 3. 空指针赋值运算符
   function &operator=(std::nullptr_t) noexcept {
-    base_ptr_.reset();
+    this->reset();
     return *this;
   }
 
@@ -114,22 +256,154 @@ public:
   // --- 修饰符 (Modifiers) ---
 
   // 交换两个 function 对象的状态
-  void swap(function &other) noexcept { std::swap(base_ptr_, other.base_ptr_); }
+  void swap(function &other) noexcept { this->swap_impl(other); }
 
   // --- 容量 (Capacity) ---
-  explicit operator bool() const noexcept {
-    return static_cast<bool>(base_ptr_);
-  }
+  explicit operator bool() const noexcept { return !this->empty(); }
 
   // --- 调用 (Invocation) ---
   R operator()(Args... args) const {
-    if (!base_ptr_) {
-      throw bad_function_call();
-    }
-    return base_ptr_->invoke(std::forward<Args>(args)...);
+    return this->call(std::forward<Args>(args)...);
   }
 }; // class function<R(Args...)>
 
+// 只移动的版本：没有拷贝入口，因此可以存放捕获了 unique_ptr、
+// 或是被整体移动进来的大缓冲区的任务，全程不发生深拷贝。
+// 与 function 共用 SBO 与分发表，也可以直接接管一个 function 的对象。
+template <typename R, typename... Args>
+class unique_function<R(Args...)>
+    : private detail::function_impl<false, R, Args...> {
+private:
+  using impl = detail::function_impl<false, R, Args...>;
+  template <typename> friend class function_ref;
+
+  template <typename F>
+  using enable_if_callable = std::enable_if_t<
+      !std::is_same_v<std::decay_t<F>, unique_function> &&
+      !std::is_same_v<std::decay_t<F>, function<R(Args...)>> &&
+      std::is_invocable_r_v<R, std::decay_t<F> &, Args...>>;
+
+public:
+  using result_type = R;
+  unique_function() noexcept = default;
+  unique_function(std::nullptr_t) noexcept : unique_function() {}
+  unique_function(const unique_function &other) = delete;
+  unique_function(unique_function &&other) noexcept : unique_function() {
+    this->move_from(other);
+  }
+  // 接管 function 的对象 (内联时移动，堆上时只转移指针)，不会再包一层
+  unique_function(function<R(Args...)> &&other) noexcept : unique_function() {
+    this->move_from(static_cast<typename function<R(Args...)>::impl &>(other));
+  }
+  unique_function(const function<R(Args...)> &other)
+      : unique_function(function<R(Args...)>(other)) {}
+  template <typename F, typename = enable_if_callable<F>>
+  unique_function(F &&f) : unique_function() {
+    this->emplace(std::forward<F>(f));
+  }
+  ~unique_function() = default;
+
+  unique_function &operator=(const unique_function &other) = delete;
+  unique_function &operator=(unique_function &&other) noexcept {
+    if (this != &other) {
+      this->reset();
+      this->move_from(other);
+    }
+    return *this;
+  }
+  unique_function &operator=(std::nullptr_t) noexcept {
+    this->reset();
+    return *this;
+  }
+  template <typename F, typename = std::enable_if_t<
+                            !std::is_same_v<std::decay_t<F>, unique_function> &&
+                            std::is_constructible_v<unique_function, F &&>>>
+  unique_function &operator=(F &&f) {
+    unique_function(std::forward<F>(f)).swap(*this);
+    return *this;
+  }
+
+  void swap(unique_function &other) noexcept { this->swap_impl(other); }
+
+  explicit operator bool() const noexcept { return !this->empty(); }
+
+  R operator()(Args... args) const {
+    return this->call(std::forward<Args>(args)...);
+  }
+}; // class unique_function<R(Args...)>
+
+// 不拥有对象的可调用引用：只有 对象指针 + 跳板函数 两个指针，可平凡拷贝，
+// 从不分配内存。适合同步调用的回调参数 (访问者、比较器等)，
+// 被引用的可调用对象必须比 function_ref 活得更久。
+template <typename R, typename... Args> class function_ref<R(Args...)> {
+private:
+  using invoker_type = R (*)(void *, Args &&...);
+
+  void *obj_;
+  invoker_type invoke_;
+
+  template <typename F> static R invoke_object(void *obj, Args &&...args) {
+    if constexpr (std::is_void_v<R>) {
+      std::invoke(*static_cast<F *>(obj), std::forward<Args>(args)...);
+    } else {
+      return std::invoke(*static_cast<F *>(obj), std::forward<Args>(args)...);
+    }
+  }
+  // 函数指针不能转换成对象指针来保存其地址，直接把指针值本身存进 obj_
+  template <typename F> static R invoke_pointer(void *obj, Args &&...args) {
+    if constexpr (std::is_void_v<R>) {
+      std::invoke(reinterpret_cast<F>(obj), std::forward<Args>(args)...);
+    } else {
+      return std::invoke(reinterpret_cast<F>(obj), std::forward<Args>(args)...);
+    }
+  }
+
+  template <typename F>
+  static constexpr bool is_function_pointer =
+      std::is_pointer_v<std::decay_t<F>> &&
+      std::is_function_v<std::remove_pointer_t<std::decay_t<F>>>;
+
+  template <typename F>
+  using enable_if_callable = std::enable_if_t<
+      !std::is_same_v<std::decay_t<F>, function_ref> &&
+      !std::is_same_v<std::decay_t<F>, function<R(Args...)>> &&
+      !std::is_same_v<std::decay_t<F>, unique_function<R(Args...)>> &&
+      std::is_invocable_r_v<R, std::remove_reference_t<F> &, Args...>>;
+
+public:
+  template <typename F, typename = enable_if_callable<F>>
+  function_ref(F &&f) noexcept {
+    if constexpr (is_function_pointer<F>) {
+      obj_ = reinterpret_cast<void *>(static_cast<std::decay_t<F>>(f));
+      invoke_ = &invoke_pointer<std::decay_t<F>>;
+    } else {
+      using Object = std::remove_reference_t<F>;
+      obj_ = const_cast<void *>(static_cast<const void *>(std::addressof(f)));
+      invoke_ = &invoke_object<Object>;
+    }
+  }
+  // 直接借用 function 的存储和调用入口，不再多一层跳转；
+  // 空的 function 调用时同样抛出 bad_function_call
+  function_ref(const function<R(Args...)> &f) noexcept
+      : obj_(&static_cast<const typename function<R(Args...)>::impl &>(f)
+                  .storage_),
+        invoke_(static_cast<const typename function<R(Args...)>::impl &>(f)
+                    .invoke_) {}
+  function_ref(const unique_function<R(Args...)> &f) noexcept
+      : obj_(&static_cast<const typename unique_function<R(Args...)>::impl &>(f)
+                  .storage_),
+        invoke_(
+            static_cast<const typename unique_function<R(Args...)>::impl &>(f)
+                .invoke_) {}
+
+  function_ref(const function_ref &other) noexcept = default;
+  function_ref &operator=(const function_ref &other) noexcept = default;
+
+  R operator()(Args... args) const {
+    return invoke_(obj_, std::forward<Args>(args)...);
+  }
+}; // class function_ref<R(Args...)>
+
 // --- 非成员函数 ---
 
 // 1. 非成员 swap 函数
@@ -137,6 +411,11 @@ template <typename R, typename... Args>
 void swap(function<R(Args...)> &lhs, function<R(Args...)> &rhs) noexcept {
   lhs.swap(rhs);
 }
+template <typename R, typename... Args>
+void swap(unique_function<R(Args...)> &lhs,
+          unique_function<R(Args...)> &rhs) noexcept {
+  lhs.swap(rhs);
+}
 
 } // namespace mystd
 
@@ -0,0 +1,117 @@
+#pragma once
+#include "control_.hpp"
+#include <atomic>
+#include <type_traits>
+
+// 先单线程、需要时再升级为原子计数的混合策略：
+//   HybridSharedPtr<T> p = make_hybrid_shared<T>(...);
+//   share_across_threads(p);   // 交给其他线程之前
+//   std::thread([q = p] { ... });
+//
+// - 控制块创建后属于创建它的线程，强/弱计数都只做普通的读写，
+//   拷贝与析构的速度与 local_policy 相同，没有 lock 前缀的 RMW。
+// - share_across_threads(p) 把 p 的控制块永久切换为原子计数 (行为同 atomic_policy)。
+//   必须在引用离开创建线程之前、在创建线程上调用；之后再调用是空操作。
+//   AtomicSharedPtr<T, hybrid_policy> 在 store 时自动完成这一步。
+// - 切换的标志是计数本身的第 30 位 (shared_bit)，每次操作只做一次 load 就能
+//   决定走普通读写还是原子 RMW，控制块头部仍是 16 字节。
+// 没有切换就把引用交给其他线程 (包括经由 WeakPtr) 是数据竞争。
+struct hybrid_policy {
+  using count_type = std::atomic<int>;
+  static constexpr int shared_bit = 1 << 30;
+
+  static void increment(count_type &count) noexcept { add(count, 1); }
+  static bool increment_if_nonzero(count_type &count) noexcept {
+    int value = count.load(std::memory_order_relaxed);
+    if (!(value & shared_bit)) {
+      if (value == 0) {
+        return false;
+      }
+      count.store(value + 1, std::memory_order_relaxed);
+      return true;
+    }
+    while (value != shared_bit) {
+      if (count.compare_exchange_weak(value, value + 1,
+                                      std::memory_order_relaxed,
+                                      std::memory_order_relaxed)) {
+        return true;
+      }
+    }
+    return false;
+  }
+  static bool decrement(count_type &count) noexcept {
+    return subtract(count, 1);
+  }
+  static void add(count_type &count, int n) noexcept {
+    int value = count.load(std::memory_order_relaxed);
+    if (!(value & shared_bit)) {
+      count.store(value + n, std::memory_order_relaxed);
+      return;
+    }
+    count.fetch_add(n, std::memory_order_relaxed);
+  }
+  // 切换之后与 atomic_policy::subtract 相同：release，减到 0 时补 acquire
+  static bool subtract(count_type &count, int n) noexcept {
+    int value = count.load(std::memory_order_relaxed);
+    if (!(value & shared_bit)) {
+      count.store(value - n, std::memory_order_relaxed);
+      return value == n;
+    }
+#if defined(__SANITIZE_THREAD__)
+    return count.fetch_sub(n, std::memory_order_acq_rel) == (shared_bit | n);
+#else
+    if (count.fetch_sub(n, std::memory_order_release) == (shared_bit | n)) {
+      std::atomic_thread_fence(std::memory_order_acquire);
+      return true;
+    }
+    return false;
+#endif
+  }
+  static int load(const count_type &count) noexcept {
+    return count.load(std::memory_order_relaxed) & ~shared_bit;
+  }
+
+  // 只在创建线程上调用，此时没有其他线程访问 count，普通的 store 即可；
+  // 其他线程经由发布引用的那次同步看到标志
+  static void promote(count_type &count) noexcept {
+    int value = count.load(std::memory_order_relaxed);
+    if (!(value & shared_bit)) {
+      count.store(value | shared_bit, std::memory_order_relaxed);
+    }
+  }
+  static bool promoted(const count_type &count) noexcept {
+    return count.load(std::memory_order_relaxed) & shared_bit;
+  }
+};
+
+template <typename T> using HybridSharedPtr = SharedPtr<T, hybrid_policy>;
+template <typename T> using HybridWeakPtr = WeakPtr<T, hybrid_policy>;
+
+template <typename T, typename... Args>
+HybridSharedPtr<T> make_hybrid_shared(Args &&...args) {
+  return basic_make_shared<T, hybrid_policy>(std::forward<Args>(args)...);
+}
+
+// 把 p 的控制块切换为原子计数，之后 p 的副本可以交给任意线程。
+// 对任何可升级的 Policy 都适用，包括 padded_policy<hybrid_policy>
+template <typename T, typename Policy,
+          typename = std::enable_if_t<has_promote<Policy>::value>>
+void share_across_threads(const SharedPtr<T, Policy> &p) noexcept {
+  if (auto *ctrl = shared_ptr_access::block(p)) {
+    ctrl->share_across_threads();
+  }
+}
+template <typename T, typename Policy,
+          typename = std::enable_if_t<has_promote<Policy>::value>>
+void share_across_threads(const WeakPtr<T, Policy> &p) noexcept {
+  if (auto *ctrl = shared_ptr_access::block(p)) {
+    ctrl->share_across_threads();
+  }
+}
+
+template <typename T, typename Policy>
+auto is_shared_across_threads(const SharedPtr<T, Policy> &p) noexcept
+    -> decltype(Policy::promoted(shared_ptr_access::block(p)->ref_cnt)) {
+  auto *ctrl = shared_ptr_access::block(p);
+  return ctrl && Policy::promoted(ctrl->ref_cnt);
+}
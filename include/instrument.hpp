@@ -0,0 +1,361 @@
+#pragma once
+// 按类型统计的分配 / 引用计数埋点，定义 SMART_PTR_INSTRUMENT 后开启：
+//   g++ -DSMART_PTR_INSTRUMENT ...
+//   instrument::dump_table(std::cout);   // 或 instrument::dump_json(out)
+//
+// 未定义时 SMART_PTR_COUNT 展开为空，不产生任何代码，本文件也不引入额外的头文件。
+//
+// 计数按线程存放：每个线程每种类型一行，热路径只是本线程计数器上的一次
+// relaxed load + store，没有 RMW，也没有线程间共享的缓存行。
+// snapshot / dump 时在锁内把所有线程的行加起来，退出的线程把计数并入公共的一份。
+// 例外是存活对象数与峰值：峰值需要全局视角，用每种类型一个共享的原子数，
+// 只在对象创建/销毁 (本来就要分配/释放内存) 时更新。
+//
+// 类型按去掉 const 与数组维度后的 T 区分；SharedPtr 的事件记在 SharedPtr<T> 的 T 上，
+// 控制块与对象的事件记在控制块所管理的类型上，mystd::function 的事件记在被擦除的类型上。
+
+#ifdef SMART_PTR_INSTRUMENT
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <typeinfo>
+#include <vector>
+#if defined(__GNUG__)
+#include <cxxabi.h>
+#endif
+
+struct instrument_type_stats {
+  std::string name;
+  std::uint64_t block_allocations = 0;
+  std::uint64_t objects_created = 0;
+  std::uint64_t objects_destroyed = 0;
+  std::uint64_t copies = 0;
+  std::uint64_t releases = 0;
+  std::uint64_t lock_successes = 0;
+  std::uint64_t lock_failures = 0;
+  std::uint64_t function_inline = 0;
+  std::uint64_t function_heap = 0;
+  std::int64_t live = 0;
+  std::int64_t peak_live = 0;
+
+  double lock_success_rate() const noexcept {
+    std::uint64_t total = lock_successes + lock_failures;
+    return total ? static_cast<double>(lock_successes) / total : 0.0;
+  }
+};
+
+class instrument {
+public:
+  enum event : unsigned {
+    block_allocations,
+    objects_created,
+    objects_destroyed,
+    copies,
+    releases,
+    lock_successes,
+    lock_failures,
+    function_inline,
+    function_heap,
+    event_count
+  };
+
+  // 埋点出现在 noexcept 路径上 (release、lock 等)，登记类型或线程时分配失败就丢掉这次计数
+  template <typename T>
+  static void count(event e, std::uint64_t n = 1) noexcept {
+    try {
+      add(record<std::remove_cv_t<std::remove_extent_t<T>>>(), e, n);
+    } catch (...) {
+    }
+  }
+
+  // 按类型第一次出现的顺序返回所有类型的合计
+  static std::vector<instrument_type_stats> snapshot() {
+    registry &r = get_registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    std::vector<instrument_type_stats> result(r.types.size());
+    for (std::size_t id = 0; id < r.types.size(); ++id) {
+      std::uint64_t totals[event_count] = {};
+      if (id < r.retired.size()) {
+        for (unsigned e = 0; e < event_count; ++e) {
+          totals[e] = r.retired[id].values[e].load(std::memory_order_relaxed);
+        }
+      }
+      for (thread_rows *rows : r.threads) {
+        if (id < rows->rows.size() && rows->rows[id]) {
+          for (unsigned e = 0; e < event_count; ++e) {
+            totals[e] +=
+                rows->rows[id]->values[e].load(std::memory_order_relaxed);
+          }
+        }
+      }
+      instrument_type_stats &s = result[id];
+      s.name = r.types[id]->name;
+      s.block_allocations = totals[block_allocations];
+      s.objects_created = totals[objects_created];
+      s.objects_destroyed = totals[objects_destroyed];
+      s.copies = totals[copies];
+      s.releases = totals[releases];
+      s.lock_successes = totals[lock_successes];
+      s.lock_failures = totals[lock_failures];
+      s.function_inline = totals[function_inline];
+      s.function_heap = totals[function_heap];
+      s.live = r.types[id]->live.load(std::memory_order_relaxed);
+      s.peak_live = r.types[id]->peak.load(std::memory_order_relaxed);
+    }
+    return result;
+  }
+
+  // 按名字查找一种类型的合计，没有记录时返回全 0
+  template <typename T> static instrument_type_stats stats() {
+    std::string name =
+        type_name(typeid(std::remove_cv_t<std::remove_extent_t<T>>).name());
+    for (instrument_type_stats &s : snapshot()) {
+      if (s.name == name) {
+        return s;
+      }
+    }
+    instrument_type_stats empty;
+    empty.name = name;
+    return empty;
+  }
+
+  static void dump_table(std::ostream &out) {
+    static const char *const headers[] = {
+        "blocks",  "live",      "peak",      "copies", "releases",
+        "lock_ok", "lock_fail", "fn_inline", "fn_heap"};
+    std::vector<instrument_type_stats> all = snapshot();
+    std::size_t width = 4;
+    for (const instrument_type_stats &s : all) {
+      width = s.name.size() > width ? s.name.size() : width;
+    }
+    out << pad("type", width);
+    for (const char *h : headers) {
+      out << ' ' << pad_left(h, 10);
+    }
+    out << '\n';
+    for (const instrument_type_stats &s : all) {
+      out << pad(s.name, width);
+      const long long values[] = {
+          static_cast<long long>(s.block_allocations), s.live, s.peak_live,
+          static_cast<long long>(s.copies),
+          static_cast<long long>(s.releases),
+          static_cast<long long>(s.lock_successes),
+          static_cast<long long>(s.lock_failures),
+          static_cast<long long>(s.function_inline),
+          static_cast<long long>(s.function_heap)};
+      for (long long v : values) {
+        out << ' ' << pad_left(std::to_string(v), 10);
+      }
+      out << '\n';
+    }
+  }
+
+  // {"types":[{"name":"...","block_allocations":1,...},...]}
+  static void dump_json(std::ostream &out) {
+    out << "{\"types\":[";
+    bool first = true;
+    for (const instrument_type_stats &s : snapshot()) {
+      out << (first ? "" : ",") << "{\"name\":\"" << escape(s.name) << '"'
+          << ",\"block_allocations\":" << s.block_allocations
+          << ",\"objects_created\":" << s.objects_created
+          << ",\"objects_destroyed\":" << s.objects_destroyed
+          << ",\"live\":" << s.live << ",\"peak_live\":" << s.peak_live
+          << ",\"copies\":" << s.copies << ",\"releases\":" << s.releases
+          << ",\"lock_successes\":" << s.lock_successes
+          << ",\"lock_failures\":" << s.lock_failures
+          << ",\"function_inline\":" << s.function_inline
+          << ",\"function_heap\":" << s.function_heap << '}';
+      first = false;
+    }
+    out << "]}";
+  }
+
+private:
+  struct counter_row {
+    std::atomic<std::uint64_t> values[event_count];
+    counter_row() noexcept {
+      for (auto &v : values) {
+        v.store(0, std::memory_order_relaxed);
+      }
+    }
+  };
+
+  struct type_record {
+    std::size_t id;
+    std::string name;
+    std::atomic<std::int64_t> live{0};
+    std::atomic<std::int64_t> peak{0};
+  };
+
+  // 一个线程的全部计数；rows 只由所属线程在锁内增长，其他线程只在锁内读取
+  struct thread_rows {
+    std::vector<std::unique_ptr<counter_row>> rows;
+    thread_rows();
+    ~thread_rows();
+  };
+
+  struct registry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<type_record>> types;
+    std::vector<thread_rows *> threads;
+    std::vector<counter_row> retired; // 已退出线程的合计
+  };
+  // 永不析构：其他静态对象的析构函数里仍可能放出 SharedPtr
+  static registry &get_registry() {
+    static registry *r = new registry;
+    return *r;
+  }
+
+  template <typename T> static type_record &record() {
+    static type_record &type = register_type(typeid(T).name());
+    return type;
+  }
+  static type_record &register_type(const char *mangled) {
+    registry &r = get_registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    auto type = std::make_unique<type_record>();
+    type->id = r.types.size();
+    type->name = type_name(mangled);
+    r.types.push_back(std::move(type));
+    return *r.types.back();
+  }
+
+  static void add(type_record &type, event e, std::uint64_t n) {
+    if (counter_row *row = local_row(type.id)) {
+      std::atomic<std::uint64_t> &counter = row->values[e];
+      counter.store(counter.load(std::memory_order_relaxed) + n,
+                    std::memory_order_relaxed);
+    } else {
+      count_retired(type.id, e, n);
+    }
+    if (e == objects_created) {
+      std::int64_t live =
+          type.live.fetch_add(static_cast<std::int64_t>(n),
+                              std::memory_order_relaxed) +
+          static_cast<std::int64_t>(n);
+      std::int64_t peak = type.peak.load(std::memory_order_relaxed);
+      while (live > peak && !type.peak.compare_exchange_weak(
+                                peak, live, std::memory_order_relaxed)) {
+      }
+    } else if (e == objects_destroyed) {
+      type.live.fetch_sub(static_cast<std::int64_t>(n),
+                          std::memory_order_relaxed);
+    }
+  }
+
+  static bool &exited() noexcept {
+    static thread_local bool value = false;
+    return value;
+  }
+  // 线程退出过程中 (本线程的计数已经并入 retired) 返回 nullptr
+  static counter_row *local_row(std::size_t id) {
+    if (exited()) {
+      return nullptr;
+    }
+    static thread_local thread_rows local;
+    if (id >= local.rows.size() || !local.rows[id]) {
+      std::lock_guard<std::mutex> lock(get_registry().mutex);
+      if (id >= local.rows.size()) {
+        local.rows.resize(id + 1);
+      }
+      local.rows[id] = std::make_unique<counter_row>();
+    }
+    return local.rows[id].get();
+  }
+  // 调用方持有 registry 的锁
+  static void grow_retired(registry &r, std::size_t size) {
+    if (r.retired.size() >= size) {
+      return;
+    }
+    std::vector<counter_row> grown(size);
+    for (std::size_t id = 0; id < r.retired.size(); ++id) {
+      for (unsigned e = 0; e < event_count; ++e) {
+        grown[id].values[e].store(
+            r.retired[id].values[e].load(std::memory_order_relaxed),
+            std::memory_order_relaxed);
+      }
+    }
+    r.retired.swap(grown);
+  }
+  static void count_retired(std::size_t id, event e, std::uint64_t n) {
+    registry &r = get_registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    grow_retired(r, id + 1);
+    std::atomic<std::uint64_t> &total = r.retired[id].values[e];
+    total.store(total.load(std::memory_order_relaxed) + n,
+                std::memory_order_relaxed);
+  }
+
+  static std::string type_name(const char *mangled) {
+#if defined(__GNUG__)
+    int status = 0;
+    char *demangled = abi::__cxa_demangle(mangled, nullptr, nullptr, &status);
+    if (status == 0 && demangled) {
+      std::string result(demangled);
+      std::free(demangled);
+      return result;
+    }
+#endif
+    return mangled;
+  }
+
+  static std::string pad(const std::string &s, std::size_t width) {
+    return s.size() < width ? s + std::string(width - s.size(), ' ') : s;
+  }
+  static std::string pad_left(const std::string &s, std::size_t width) {
+    return s.size() < width ? std::string(width - s.size(), ' ') + s : s;
+  }
+  static std::string escape(const std::string &s) {
+    std::string result;
+    for (char c : s) {
+      if (c == '"' || c == '\\') {
+        result += '\\';
+      }
+      result += c;
+    }
+    return result;
+  }
+};
+
+inline instrument::thread_rows::thread_rows() {
+  registry &r = get_registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  r.threads.push_back(this);
+}
+
+// 线程退出时把本线程的计数并入 retired
+inline instrument::thread_rows::~thread_rows() {
+  exited() = true;
+  registry &r = get_registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  grow_retired(r, rows.size());
+  for (std::size_t id = 0; id < rows.size(); ++id) {
+    if (!rows[id]) {
+      continue;
+    }
+    for (unsigned e = 0; e < event_count; ++e) {
+      std::atomic<std::uint64_t> &total = r.retired[id].values[e];
+      total.store(total.load(std::memory_order_relaxed) +
+                      rows[id]->values[e].load(std::memory_order_relaxed),
+                  std::memory_order_relaxed);
+    }
+  }
+  for (std::size_t i = 0; i < r.threads.size(); ++i) {
+    if (r.threads[i] == this) {
+      r.threads.erase(r.threads.begin() + static_cast<std::ptrdiff_t>(i));
+      break;
+    }
+  }
+}
+
+#define SMART_PTR_COUNT(T, e) ::instrument::count<T>(::instrument::e)
+#define SMART_PTR_COUNT_N(T, e, n) ::instrument::count<T>(::instrument::e, (n))
+#else
+#define SMART_PTR_COUNT(T, e) ((void)0)
+#define SMART_PTR_COUNT_N(T, e, n) ((void)0)
+#endif
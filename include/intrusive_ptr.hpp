@@ -0,0 +1,146 @@
+#pragma once
+#include "control_.hpp"
+
+// 侵入式引用计数：计数放在对象自身里，没有单独的控制块，IntrusivePtr 只有一个指针大小。
+// 用法: struct Node : intrusive_ref_counter<Node> { ... };
+//
+// 对象本身就是控制块 (basic_control_block_base)，因此可以直接交给 SharedPtr
+// 共享同一组计数，不需要第二次分配，见 shared_from_intrusive。
+// 注意：控制块与对象是同一块内存，强计数归零时无法只析构对象，
+// 析构和释放一起推迟到最后一个 WeakPtr 离开时。
+template <typename T, typename Policy = atomic_policy>
+class intrusive_ref_counter : public basic_control_block_base<Policy> {
+public:
+  // 新对象强计数为 0，由第一个 IntrusivePtr 接管时加 1
+  intrusive_ref_counter() : basic_control_block_base<Policy>(0, 1) {}
+  // 拷贝对象不拷贝计数
+  intrusive_ref_counter(const intrusive_ref_counter &)
+      : basic_control_block_base<Policy>(0, 1) {}
+  intrusive_ref_counter &operator=(const intrusive_ref_counter &) {
+    return *this;
+  }
+
+private:
+  // 强计数归零后紧接着 release_weak，对象经虚析构函数随 delete this 一起销毁
+  void delete_ptr() final {}
+  // 没有单独要析构的对象，省掉对空 delete_ptr 的那一次虚调用
+  void release_last() noexcept final { this->release_weak(); }
+};
+
+template <typename T> class IntrusivePtr {
+private:
+  template <typename> friend class IntrusivePtr;
+  using policy_type = typename T::policy_type;
+  using block_type = basic_control_block_base<policy_type>;
+  T *ptr;
+
+  static block_type *block(T *p) noexcept { return p; }
+  void release() noexcept {
+    if (ptr) {
+      block(ptr)->release();
+    }
+  }
+
+public:
+  IntrusivePtr() noexcept : ptr(nullptr) {}
+  IntrusivePtr(std::nullptr_t) noexcept : ptr(nullptr) {}
+  // add_ref 为 false 时接管一个调用方已经计过数的引用
+  IntrusivePtr(T *p, bool add_ref = true) noexcept : ptr(p) {
+    if (ptr && add_ref) {
+      block(ptr)->add_ref();
+    }
+  }
+  IntrusivePtr(const IntrusivePtr &other) noexcept : IntrusivePtr(other.ptr) {}
+  IntrusivePtr(IntrusivePtr &&other) noexcept : ptr(other.ptr) {
+    other.ptr = nullptr;
+  }
+  template <typename U>
+  IntrusivePtr(const IntrusivePtr<U> &other) noexcept
+      : IntrusivePtr(static_cast<T *>(other.ptr)) {
+    static_assert(std::is_convertible<U *, T *>::value,
+                  "U* must be convertible to T*");
+  }
+  template <typename U>
+  IntrusivePtr(IntrusivePtr<U> &&other) noexcept
+      : ptr(static_cast<T *>(other.ptr)) {
+    static_assert(std::is_convertible<U *, T *>::value,
+                  "U* must be convertible to T*");
+    other.ptr = nullptr;
+  }
+  ~IntrusivePtr() { release(); }
+
+  IntrusivePtr &operator=(const IntrusivePtr &other) noexcept {
+    IntrusivePtr temp(other);
+    swap(temp);
+    return *this;
+  }
+  IntrusivePtr &operator=(IntrusivePtr &&other) noexcept {
+    IntrusivePtr temp(std::move(other));
+    swap(temp);
+    return *this;
+  }
+  template <typename U>
+  IntrusivePtr &operator=(const IntrusivePtr<U> &other) noexcept {
+    IntrusivePtr temp(other);
+    swap(temp);
+    return *this;
+  }
+  template <typename U>
+  IntrusivePtr &operator=(IntrusivePtr<U> &&other) noexcept {
+    IntrusivePtr temp(std::move(other));
+    swap(temp);
+    return *this;
+  }
+  IntrusivePtr &operator=(std::nullptr_t) noexcept {
+    release();
+    ptr = nullptr;
+    return *this;
+  }
+
+  void swap(IntrusivePtr &other) noexcept { std::swap(ptr, other.ptr); }
+  // 放弃所有权但不减计数，返回的指针由调用方负责 (可再交给 IntrusivePtr(p, false))
+  T *detach() noexcept {
+    T *p = ptr;
+    ptr = nullptr;
+    return p;
+  }
+
+  T *get() const noexcept { return ptr; }
+  T &operator*() const noexcept { return *ptr; }
+  T *operator->() const noexcept { return ptr; }
+  explicit operator bool() const noexcept { return ptr != nullptr; }
+  int use_count() const noexcept { return ptr ? block(ptr)->use_count() : 0; }
+};
+
+template <typename T>
+void swap(IntrusivePtr<T> &lhs, IntrusivePtr<T> &rhs) noexcept {
+  lhs.swap(rhs);
+}
+
+template <typename T, typename... Args>
+IntrusivePtr<T> make_intrusive(Args &&...args) {
+  return IntrusivePtr<T>(new T(std::forward<Args>(args)...));
+}
+
+// 把侵入式对象交给 SharedPtr：对象自身充当控制块，与 IntrusivePtr 共用同一个强计数。
+// T 不能再派生自 EnableSharedFromThis：weak_this 会是对象对自身的弱引用，
+// 弱计数永远不归零，对象泄漏；需要时直接 shared_from_intrusive(this)
+template <typename T>
+SharedPtr<T, typename T::policy_type> shared_from_intrusive(T *p) noexcept {
+  static_assert(!is_enable_shared_from_this<T>::value,
+                "an intrusive_ref_counter type is its own control block and "
+                "cannot also derive from EnableSharedFromThis");
+  using block_type = basic_control_block_base<typename T::policy_type>;
+  if (!p) {
+    return SharedPtr<T, typename T::policy_type>();
+  }
+  block_type *ctrl = p;
+  ctrl->add_ref();
+  return shared_ptr_access::make<T, typename T::policy_type>(p, ctrl);
+}
+
+template <typename T>
+SharedPtr<T, typename T::policy_type>
+shared_from_intrusive(const IntrusivePtr<T> &p) noexcept {
+  return shared_from_intrusive(p.get());
+}
@@ -0,0 +1,217 @@
+#pragma once
+#include "control_.hpp"
+#include "func.hpp"
+#include "unique_ptr.hpp"
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// 同类型短命对象的回收池：对象与控制块放在预先分配的槽位里，
+// acquire() 交出 SharedPtr<T, Policy>，acquire_unique() 交出
+// unique_ptr<T, PoolDeleter<T, Policy>>。最后一个引用离开时对象回到池中而不是
+// 被 delete，槽位用完之前整个热路径上没有任何分配。
+//
+// - 控制块是 control_block<T, recycler> 的 final 派生类：delete_ptr 经删除器把对象
+//   还给池，destroy 不 delete 自己，而是在最后一个 WeakPtr 离开后把槽位还给池。
+// - 给了 reset 回调时，释放只调用 reset(obj)，对象保持构造状态；
+//   之后不带参数的 acquire() 直接复用它，带参数时仍然析构后重新构造。
+//   reset 抛出异常时退回为析构对象。派生自 EnableSharedFromThis 的对象在 reset
+//   之前清空 weak_this，下一次 acquire() 再指向新的控制块。
+// - acquire 只能在创建池的线程上调用；SharedPtr 与 unique_ptr 可以在任意线程释放
+//   (local_policy 的池整体只限单线程)。在创建线程上释放的槽位直接挂回本地空闲链表，
+//   其他线程归还的先压入一个无锁栈，本地链表用完时一次取走。
+// - 槽位用完时按当前容量翻倍再分配一块；内存只在池析构时归还。
+//   池必须比从它取出的所有指针 (包括 WeakPtr) 活得更久。
+
+template <typename T, typename Policy = atomic_policy> class ObjectPool;
+
+// unique_ptr 的删除器：对象与槽位一起还给池
+template <typename T, typename Policy = atomic_policy> class PoolDeleter {
+public:
+  PoolDeleter() noexcept = default;
+  explicit PoolDeleter(ObjectPool<T, Policy> *p) noexcept : pool(p) {}
+  void operator()(T *p) const noexcept { pool->recycle(p); }
+
+private:
+  ObjectPool<T, Policy> *pool = nullptr;
+};
+
+template <typename T, typename Policy> class ObjectPool {
+public:
+  using unique_type = ::unique_ptr<T, PoolDeleter<T, Policy>>;
+  using reset_type = mystd::function<void(T &)>;
+
+  explicit ObjectPool(std::size_t initial_capacity = 64,
+                      reset_type reset = nullptr)
+      : reset_hook(std::move(reset)),
+        owner_thread(std::this_thread::get_id()) {
+    grow(initial_capacity ? initial_capacity : 1);
+  }
+  ObjectPool(const ObjectPool &) = delete;
+  ObjectPool &operator=(const ObjectPool &) = delete;
+  // 析构仍处于构造状态的对象 (即 reset 过、留在池里的那些)
+  ~ObjectPool() {
+    for (slab &s : slabs) {
+      for (std::size_t i = 0; i < s.count; ++i) {
+        if (s.slots[i].constructed) {
+          s.slots[i].get()->~T();
+        }
+      }
+    }
+  }
+
+  template <typename... Args> SharedPtr<T, Policy> acquire(Args &&...args) {
+    slot *s = take();
+    T *object = prepare(s, std::forward<Args>(args)...);
+    auto *ctrl = ::new (static_cast<void *>(s->block)) block_type(object);
+    return shared_ptr_access::make<T, Policy>(object, ctrl);
+  }
+  template <typename... Args> unique_type acquire_unique(Args &&...args) {
+    slot *s = take();
+    return unique_type(prepare(s, std::forward<Args>(args)...),
+                       PoolDeleter<T, Policy>(this));
+  }
+
+  // 已分配的槽位总数 (只在创建池的线程上读)
+  std::size_t capacity() const noexcept { return total; }
+  std::size_t slab_count() const noexcept { return slabs.size(); }
+
+private:
+  friend class PoolDeleter<T, Policy>;
+  struct slot;
+
+  // 控制块的删除器：只处理对象 (reset 或析构)，槽位留给 destroy
+  struct recycler {
+    void operator()(T *p) const noexcept {
+      slot *s = slot_of(p);
+      s->owner->release_object(s);
+    }
+  };
+
+  class block_type final : public control_block<T, recycler, Policy> {
+  public:
+    explicit block_type(T *p) : control_block<T, recycler, Policy>(p) {}
+    void release_last() noexcept override {
+      control_block<T, recycler, Policy>::delete_ptr();
+      if (this->drop_weak()) {
+        destroy();
+      }
+    }
+    void destroy() noexcept override {
+      slot *s = slot_of(this->ptr);
+      this->~block_type();
+      s->owner->give_back(s);
+    }
+  };
+
+  struct slot {
+    alignas(T) unsigned char object[sizeof(T)];
+    alignas(block_type) unsigned char block[sizeof(block_type)];
+    slot *next = nullptr;
+    ObjectPool *owner = nullptr;
+    bool constructed = false;
+    T *get() noexcept { return std::launder(reinterpret_cast<T *>(object)); }
+  };
+  struct slab {
+    std::unique_ptr<slot[]> slots;
+    std::size_t count;
+  };
+
+  static constexpr bool single_thread =
+      is_single_thread_policy<Policy>::value;
+
+  // 对象位于槽位起始处
+  static slot *slot_of(T *p) noexcept {
+    return reinterpret_cast<slot *>(reinterpret_cast<unsigned char *>(p));
+  }
+
+  void grow(std::size_t count) {
+    std::unique_ptr<slot[]> slots(new slot[count]);
+    for (std::size_t i = 0; i < count; ++i) {
+      slots[i].owner = this;
+      slots[i].next = i + 1 < count ? &slots[i + 1] : free_list;
+    }
+    free_list = &slots[0];
+    slabs.push_back(slab{std::move(slots), count});
+    total += count;
+  }
+
+  slot *take() {
+    assert(single_thread || std::this_thread::get_id() == owner_thread);
+    if (!free_list) {
+      free_list = returned.exchange(nullptr, std::memory_order_acquire);
+      if (!free_list) {
+        grow(total);
+      }
+    }
+    slot *s = free_list;
+    free_list = s->next;
+    return s;
+  }
+
+  template <typename... Args> T *prepare(slot *s, Args &&...args) {
+    if (s->constructed) {
+      if (sizeof...(Args) == 0) {
+        return s->get();
+      }
+      s->get()->~T();
+      s->constructed = false;
+    }
+    try {
+      ::new (static_cast<void *>(s->object)) T(std::forward<Args>(args)...);
+    } catch (...) {
+      s->next = free_list;
+      free_list = s;
+      throw;
+    }
+    s->constructed = true;
+    return s->get();
+  }
+
+  void release_object(slot *s) noexcept {
+    if (reset_hook) {
+      forget_shared_from_this_hook(s->get());
+      try {
+        reset_hook(*s->get());
+        return;
+      } catch (...) {
+      }
+    }
+    s->get()->~T();
+    s->constructed = false;
+  }
+
+  void give_back(slot *s) noexcept {
+    if (single_thread || std::this_thread::get_id() == owner_thread) {
+      s->next = free_list;
+      free_list = s;
+    } else {
+      slot *head = returned.load(std::memory_order_relaxed);
+      do {
+        s->next = head;
+      } while (!returned.compare_exchange_weak(
+          head, s, std::memory_order_release, std::memory_order_relaxed));
+    }
+  }
+
+  void recycle(T *p) noexcept {
+    slot *s = slot_of(p);
+    release_object(s);
+    give_back(s);
+  }
+
+  reset_type reset_hook;
+  std::thread::id owner_thread;
+  slot *free_list = nullptr;             // 只由创建池的线程访问
+  std::atomic<slot *> returned{nullptr}; // 其他线程归还、尚未取回的槽位
+  std::vector<slab> slabs;
+  std::size_t total = 0;
+};
+
+template <typename T> using LocalObjectPool = ObjectPool<T, local_policy>;
@@ -0,0 +1,105 @@
+#pragma once
+#include "control_.hpp"
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+// 控制块的两种布局：
+// - 紧凑 (默认 atomic_policy)：vptr + 弱计数 + 强计数共 16 字节，make_shared 的对象
+//   紧跟其后，小对象与计数通常在同一条缓存行上。适合单线程或低争用的对象。
+// - 填充 (padded_policy)：强计数独占一条缓存行，vptr 与弱计数在它前面一行，
+//   make_shared 的对象从再下一行开始。拷贝 SharedPtr / lock() 的计数流量
+//   不再与 WeakPtr 的增减、以及对对象本身的读写伪共享。代价是每个控制块
+//   至少 128 字节 (make_shared 至少 192 字节)，且超出默认对齐，不走 block_pool。
+//
+// 按类型选择布局：特化 shared_layout<T> 继承 padded_layout，
+// 然后用 LayoutSharedPtr<T> / make_layout_shared<T>，未特化的类型仍是紧凑布局：
+//   template <> struct shared_layout<HotCounter> : padded_layout {};
+//   LayoutSharedPtr<HotCounter> p = make_layout_shared<HotCounter>();
+// 布局属于 Policy，不同布局的指针之间与不同 Policy 一样不能互相转换。
+
+constexpr std::size_t cache_line_size = 64;
+
+// 把 Base 的强计数放进独占一条缓存行的 count_type，其余行为与 Base 相同。
+// 弱计数沿用 Base 的弱计数策略，保持紧凑
+template <typename Base = atomic_policy> struct padded_policy;
+template <typename Base>
+struct is_single_thread_policy<padded_policy<Base>>
+    : is_single_thread_policy<Base> {};
+
+template <typename Base> struct padded_policy {
+  static_assert(!has_deferred_release<Base>::value,
+                "padded_policy cannot wrap a deferred_release policy");
+  using weak_policy = typename weak_policy_of<Base>::type;
+
+  struct alignas(cache_line_size) count_type {
+    explicit count_type(int initial) : value(initial) {}
+    typename Base::count_type value;
+  };
+
+  static void increment(count_type &count) noexcept {
+    Base::increment(count.value);
+  }
+  static bool increment_if_nonzero(count_type &count) noexcept {
+    return Base::increment_if_nonzero(count.value);
+  }
+  static bool decrement(count_type &count) noexcept {
+    return Base::decrement(count.value);
+  }
+  // Base 有批量操作时才提供，否则 control_block 退化为逐个增减
+  template <typename B = Base>
+  static auto add(count_type &count, int n) noexcept
+      -> decltype(B::add(count.value, n)) {
+    return B::add(count.value, n);
+  }
+  template <typename B = Base>
+  static auto subtract(count_type &count, int n) noexcept
+      -> decltype(B::subtract(count.value, n)) {
+    return B::subtract(count.value, n);
+  }
+  static int load(const count_type &count) noexcept {
+    return Base::load(count.value);
+  }
+  // 同理：Base 可升级 (hybrid_policy) 时，share_across_threads 也要升级强计数
+  template <typename B = Base>
+  static auto promote(count_type &count) noexcept
+      -> decltype(B::promote(count.value)) {
+    return B::promote(count.value);
+  }
+  template <typename B = Base>
+  static auto promoted(const count_type &count) noexcept
+      -> decltype(B::promoted(count.value)) {
+    return B::promoted(count.value);
+  }
+};
+
+// vptr 与弱计数占第一行，强计数 (按行对齐) 恰好是第二行
+static_assert(alignof(basic_control_block_base<padded_policy<>>) ==
+                      cache_line_size &&
+                  sizeof(basic_control_block_base<padded_policy<>>) ==
+                      2 * cache_line_size,
+              "the padded header should be exactly two cache lines");
+
+struct compact_layout {
+  using policy = atomic_policy;
+};
+struct padded_layout {
+  using policy = padded_policy<atomic_policy>;
+};
+
+// 默认紧凑；为热点类型特化为 padded_layout
+template <typename T> struct shared_layout : compact_layout {};
+
+template <typename T>
+using shared_layout_policy_t = typename shared_layout<T>::policy;
+
+template <typename T>
+using LayoutSharedPtr = SharedPtr<T, shared_layout_policy_t<T>>;
+template <typename T>
+using LayoutWeakPtr = WeakPtr<T, shared_layout_policy_t<T>>;
+
+template <typename T, typename... Args>
+LayoutSharedPtr<T> make_layout_shared(Args &&...args) {
+  return basic_make_shared<T, shared_layout_policy_t<T>>(
+      std::forward<Args>(args)...);
+}
@@ -0,0 +1,206 @@
+#pragma once
+#include "control_.hpp"
+#include "deferred_block.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+// 延迟析构队列：最后一个强引用离开时不在当前线程执行析构，而是把对象挂进
+// 无锁的多生产者单消费者队列，由后台线程或显式的 drain() 成批析构。
+// 用于在延迟敏感的线程上释放大对象图，避免析构链计入请求的尾延迟。
+//
+// 生产者 (释放最后一个强引用的线程) 只做一次 CAS 把节点压入栈顶；
+// 消费者一次 exchange 取走整个栈，翻转成先进先出的顺序后依次析构。
+// 析构期间再被延迟的对象 (例如子对象) 进入下一批。
+// 队列必须比所有交给它的对象活得更久，析构时剩下的对象全部立刻析构。
+
+// 可被延迟析构的对象的侵入式链表节点；控制块混入时 push 本身不需要分配内存
+struct reclaim_node {
+  reclaim_node *next = nullptr;
+  void (*reclaim)(reclaim_node *) = nullptr;
+};
+
+class reclaim_queue {
+public:
+  reclaim_queue() = default;
+  reclaim_queue(const reclaim_queue &) = delete;
+  reclaim_queue &operator=(const reclaim_queue &) = delete;
+  ~reclaim_queue() {
+    stop();
+    drain();
+  }
+
+  // 任意线程可调用，无锁；节点稍后由 reclaim 回调析构
+  void push(reclaim_node *node, void (*reclaim)(reclaim_node *)) noexcept {
+    node->reclaim = reclaim;
+    reclaim_node *head = stack.load(std::memory_order_relaxed);
+    do {
+      node->next = head;
+    } while (!stack.compare_exchange_weak(head, node,
+                                          std::memory_order_release,
+                                          std::memory_order_relaxed));
+    // 只在队列由空变为非空时唤醒后台线程；漏掉的唤醒由等待超时兜底
+    if (!head && worker_running.load(std::memory_order_relaxed)) {
+      wakeup.notify_one();
+    }
+  }
+  // 不经控制块、单独分配一个节点，由消费者调用 d(p)；供 deferred_delete 使用。
+  // 分配节点失败时退回当场调用 d(p)
+  template <typename T, typename D> void defer(T *p, D d) noexcept {
+    struct holder : reclaim_node {
+      holder(T *p, D &&d) : object(p), deleter(std::move(d)) {}
+      T *object;
+      D deleter;
+    };
+    holder *node = nullptr;
+    try {
+      node = new holder(p, std::move(d));
+    } catch (...) {
+      d(p);
+      return;
+    }
+    push(static_cast<reclaim_node *>(node), [](reclaim_node *n) {
+      auto *h = static_cast<holder *>(n);
+      h->deleter(h->object);
+      delete h;
+    });
+  }
+
+  // 按进入队列的顺序析构最多 max_batch 个对象，返回实际析构的个数。
+  // 不限个数时一直析构到队列为空，包括析构过程中新进入队列的对象。
+  // 不能在 reclaim 回调 (即被延迟对象的析构函数) 里调用
+  std::size_t drain(std::size_t max_batch = std::size_t(-1)) {
+    std::lock_guard<std::mutex> lock(consumer_mutex);
+    std::size_t done = 0;
+    while (done < max_batch) {
+      if (!backlog) {
+        backlog = reverse(stack.exchange(nullptr, std::memory_order_acquire));
+        if (!backlog) {
+          break;
+        }
+      }
+      reclaim_node *node = backlog;
+      backlog = node->next;
+      node->reclaim(node);
+      ++done;
+    }
+    return done;
+  }
+
+  // 启动后台析构线程：队列非空时被唤醒，每轮最多析构 batch 个后让出一次；
+  // 至少每隔 interval 检查一次队列。后台线程运行期间仍可以手动 drain
+  void start(std::size_t batch = 256,
+             std::chrono::milliseconds interval =
+                 std::chrono::milliseconds(10)) {
+    std::lock_guard<std::mutex> lock(worker_mutex);
+    if (worker.joinable()) {
+      return;
+    }
+    stopping = false;
+    worker_running.store(true, std::memory_order_relaxed);
+    worker = std::thread([this, batch, interval] { run(batch, interval); });
+  }
+  // 停止后台线程；队列里剩下的对象留给下一次 drain
+  void stop() {
+    {
+      std::lock_guard<std::mutex> lock(worker_mutex);
+      if (!worker.joinable()) {
+        return;
+      }
+      stopping = true;
+      worker_running.store(false, std::memory_order_relaxed);
+    }
+    wakeup.notify_one();
+    worker.join();
+  }
+
+private:
+  static reclaim_node *reverse(reclaim_node *list) noexcept {
+    reclaim_node *reversed = nullptr;
+    while (list) {
+      reclaim_node *next = list->next;
+      list->next = reversed;
+      reversed = list;
+      list = next;
+    }
+    return reversed;
+  }
+
+  void run(std::size_t batch, std::chrono::milliseconds interval) {
+    std::unique_lock<std::mutex> lock(worker_mutex);
+    while (!stopping) {
+      lock.unlock();
+      std::size_t done = drain(batch);
+      lock.lock();
+      if (done < batch) {
+        wakeup.wait_for(lock, interval, [this] {
+          return stopping || stack.load(std::memory_order_relaxed);
+        });
+      } else {
+        lock.unlock();
+        std::this_thread::yield();
+        lock.lock();
+      }
+    }
+  }
+
+  std::atomic<reclaim_node *> stack{nullptr};
+  std::mutex consumer_mutex;       // 串行化消费者，生产者从不获取它
+  reclaim_node *backlog = nullptr; // 已取出、按先进先出排好但还没析构的部分
+
+  std::mutex worker_mutex;
+  std::condition_variable wakeup;
+  std::thread worker;
+  bool stopping = false;
+  std::atomic<bool> worker_running{false};
+};
+
+inline reclaim_queue &default_reclaim_queue() {
+  static reclaim_queue queue;
+  return queue;
+}
+
+// deferred_block 的控制块压入队列，由消费者析构
+template <> struct deferred_sink<reclaim_queue> {
+  using node_type = reclaim_node;
+  static void defer(reclaim_queue &queue, reclaim_node *node,
+                    void (*reclaim)(reclaim_node *)) noexcept {
+    queue.push(node, reclaim);
+  }
+};
+
+// 删除器形式，直接用于 SharedPtr(p, deleter) / control_block<T>(p, deleter)：
+// 把 p 连同内层删除器 D 交给队列，由消费者调用 D。每次延迟需要分配一个节点，
+// 不想在释放时分配的话用下面的 make_deferred_shared / deferred_shared
+template <typename T, typename D = default_delete_for<T>>
+class deferred_delete {
+public:
+  explicit deferred_delete(reclaim_queue &q = default_reclaim_queue(),
+                           D d = D())
+      : queue(&q), inner(std::move(d)) {}
+  void operator()(std::remove_extent_t<T> *p) const {
+    if (p) {
+      queue->defer(p, inner);
+    }
+  }
+
+private:
+  reclaim_queue *queue;
+  D inner;
+};
+
+// 对象与控制块一次分配，析构交给 queue
+template <typename T, typename... Args>
+SharedPtr<T> make_deferred_shared(reclaim_queue &queue, Args &&...args) {
+  return basic_make_deferred_shared<T>(queue, std::forward<Args>(args)...);
+}
+
+// 接管已有的裸指针，最终在消费者线程上用 delete 释放
+template <typename T>
+SharedPtr<T> deferred_shared(reclaim_queue &queue, T *p) {
+  return basic_deferred_shared(queue, p);
+}
@@ -0,0 +1,536 @@
+#pragma once
+#include "block_pool.hpp"
+#include "control_.hpp"
+#include "func.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// 工作窃取线程池，任务类型是只移动、带 SBO 的 mystd::unique_function<void()>。
+//
+// - 每个工作线程一个 Chase-Lev 双端队列：自己在底部 push/pop (无争用时没有 RMW)，
+//   空闲的线程从别人的顶部偷。工作线程里提交的任务直接进自己的队列，
+//   fork-join 式的递归任务基本不碰任何共享数据。
+// - 池外线程提交的任务压入某个工作线程的收件箱 (无锁栈，一次 CAS)；
+//   收件箱由任何一个线程整串取走 (exchange)，放进自己的队列后再被窃取。
+//   post_batch 把一批任务先串好，只做一次 CAS 与一次唤醒。
+// - 没有任务时先自旋几轮再睡眠；睡眠/唤醒用 eventcount，提交方只有在确实有线程
+//   睡着时才会去碰互斥锁。
+// - submit 返回 task_future<R>，共享状态由 SharedPtr 管理；在工作线程里 wait/get
+//   时不会阻塞，而是先执行别的任务直到结果就绪，嵌套等待不会耗尽线程。
+// - 析构时先执行完所有已提交的任务 (包括执行中再提交的)，再停止线程。
+//   post 的任务抛出异常时调用 std::terminate，与 std::thread 一致。
+
+// Chase-Lev 工作窃取双端队列，元素是指针，空指针表示空或窃取失败。
+// push/pop 只能由所属线程调用，steal 可以由任意线程调用。
+// 扩容只发生在 push 中；旧数组可能仍被窃取者读着，留到析构时再释放
+template <typename T> class chase_lev_deque {
+  static_assert(std::is_pointer<T>::value, "chase_lev_deque stores pointers");
+
+public:
+  explicit chase_lev_deque(std::size_t capacity = 256)
+      : buffer(new ring(round_up(capacity))) {
+    retired.emplace_back(buffer.load(std::memory_order_relaxed));
+  }
+  chase_lev_deque(const chase_lev_deque &) = delete;
+  chase_lev_deque &operator=(const chase_lev_deque &) = delete;
+
+  void push(T x) {
+    std::int64_t b = bottom.load(std::memory_order_relaxed);
+    std::int64_t t = top.load(std::memory_order_acquire);
+    ring *a = buffer.load(std::memory_order_relaxed);
+    if (b - t > static_cast<std::int64_t>(a->mask)) {
+      a = grow(a, t, b);
+    }
+    a->put(b, x);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom.store(b + 1, std::memory_order_relaxed);
+  }
+
+  T pop() {
+    std::int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+    ring *a = buffer.load(std::memory_order_relaxed);
+    bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::int64_t t = top.load(std::memory_order_relaxed);
+    if (t > b) {
+      bottom.store(b + 1, std::memory_order_relaxed);
+      return nullptr;
+    }
+    T x = a->get(b);
+    if (t == b) {
+      // 只剩最后一个，与窃取者争
+      if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                       std::memory_order_relaxed)) {
+        x = nullptr;
+      }
+      bottom.store(b + 1, std::memory_order_relaxed);
+    }
+    return x;
+  }
+
+  T steal() {
+    std::int64_t t = top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::int64_t b = bottom.load(std::memory_order_acquire);
+    if (t >= b) {
+      return nullptr;
+    }
+    ring *a = buffer.load(std::memory_order_acquire);
+    T x = a->get(t);
+    if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                     std::memory_order_relaxed)) {
+      return nullptr;
+    }
+    return x;
+  }
+
+  // 只是一个瞬时的估计
+  bool empty() const noexcept {
+    return bottom.load(std::memory_order_relaxed) <=
+           top.load(std::memory_order_relaxed);
+  }
+
+private:
+  // 槽位的写用 release、读用 acquire：与 push 末尾的 fence 作用相同，
+  // 但 ThreadSanitizer 能理解，x86 上也没有额外开销
+  struct ring {
+    explicit ring(std::size_t capacity)
+        : mask(capacity - 1), slots(new std::atomic<T>[capacity]) {}
+    void put(std::int64_t i, T x) noexcept {
+      slots[static_cast<std::size_t>(i) & mask].store(
+          x, std::memory_order_release);
+    }
+    T get(std::int64_t i) const noexcept {
+      return slots[static_cast<std::size_t>(i) & mask].load(
+          std::memory_order_acquire);
+    }
+    std::size_t mask;
+    std::unique_ptr<std::atomic<T>[]> slots;
+  };
+
+  static std::size_t round_up(std::size_t n) noexcept {
+    std::size_t capacity = 2;
+    while (capacity < n) {
+      capacity *= 2;
+    }
+    return capacity;
+  }
+
+  ring *grow(ring *old, std::int64_t t, std::int64_t b) {
+    auto *bigger = new ring(2 * (old->mask + 1));
+    retired.emplace_back(bigger);
+    for (std::int64_t i = t; i < b; ++i) {
+      bigger->put(i, old->get(i));
+    }
+    buffer.store(bigger, std::memory_order_release);
+    return bigger;
+  }
+
+  // 所有者与窃取者分别写 bottom 与 top，各占一条缓存行
+  alignas(64) std::atomic<std::int64_t> top{0};
+  alignas(64) std::atomic<std::int64_t> bottom{0};
+  std::atomic<ring *> buffer;
+  std::vector<std::unique_ptr<ring>> retired; // 只由所属线程修改
+};
+
+class thread_pool;
+
+namespace detail {
+
+// 线程池内部的任务节点；小于 256 字节，从 block_pool 分配
+struct pool_task {
+  pool_task *next = nullptr;
+  mystd::unique_function<void()> fn;
+
+  explicit pool_task(mystd::unique_function<void()> &&f) : fn(std::move(f)) {}
+  static void *operator new(std::size_t size) {
+    return block_pool::allocate(size);
+  }
+  static void operator delete(void *p, std::size_t size) noexcept {
+    block_pool::deallocate(p, size);
+  }
+};
+
+// 当前线程所属的线程池与工作线程编号，不是工作线程时 pool 为 nullptr
+struct pool_context {
+  thread_pool *pool = nullptr;
+  std::size_t index = 0;
+};
+inline pool_context &current_pool_context() noexcept {
+  static thread_local pool_context context;
+  return context;
+}
+
+// 在工作线程里执行一个别的任务，没有可执行的任务时返回 false
+inline bool help_current_pool();
+
+template <typename R> class future_state {
+public:
+  bool ready() const noexcept { return done.load(std::memory_order_acquire); }
+
+  void wait() {
+    if (ready()) {
+      return;
+    }
+    // 工作线程不阻塞，执行别的任务直到结果就绪
+    if (current_pool_context().pool) {
+      while (!ready()) {
+        if (!help_current_pool()) {
+          std::this_thread::yield();
+        }
+      }
+      return;
+    }
+    has_waiters.store(true, std::memory_order_seq_cst);
+    std::unique_lock<std::mutex> lock(mutex);
+    wakeup.wait(lock, [this] { return ready(); });
+  }
+
+  template <typename F> void run(F &fn) noexcept {
+    try {
+      if constexpr (std::is_void<R>::value) {
+        fn();
+      } else {
+        value.emplace(fn());
+      }
+    } catch (...) {
+      error = std::current_exception();
+    }
+    done.store(true, std::memory_order_seq_cst);
+    // 与 wait 中 has_waiters 的写入配对：要么我们看到等待者，要么它看到 done
+    if (has_waiters.load(std::memory_order_seq_cst)) {
+      { std::lock_guard<std::mutex> lock(mutex); }
+      wakeup.notify_all();
+    }
+  }
+
+  void rethrow() const {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+  template <typename U = R> const U &get_value() const { return *value; }
+
+private:
+  std::atomic<bool> done{false};
+  std::atomic<bool> has_waiters{false};
+  std::mutex mutex;
+  std::condition_variable wakeup;
+  std::exception_ptr error;
+  std::optional<std::conditional_t<std::is_void<R>::value, char, R>> value;
+};
+
+} // namespace detail
+
+// submit 返回的结果句柄，可以拷贝，所有副本共享同一个状态 (类似 std::shared_future)
+template <typename R> class task_future {
+public:
+  task_future() = default;
+  explicit task_future(SharedPtr<detail::future_state<R>> s)
+      : state(std::move(s)) {}
+
+  bool valid() const noexcept { return state.use_count() != 0; }
+  bool ready() const noexcept { return state->ready(); }
+  void wait() const { state->wait(); }
+  // 任务抛出的异常在这里重新抛出
+  const R &get() const {
+    state->wait();
+    state->rethrow();
+    return state->get_value();
+  }
+
+private:
+  // SharedPtr 的访问函数不是 const 的
+  mutable SharedPtr<detail::future_state<R>> state;
+};
+
+// void 任务只等待完成并传播异常
+template <> class task_future<void> {
+public:
+  task_future() = default;
+  explicit task_future(SharedPtr<detail::future_state<void>> s)
+      : state(std::move(s)) {}
+
+  bool valid() const noexcept { return state.use_count() != 0; }
+  bool ready() const noexcept { return state->ready(); }
+  void wait() const { state->wait(); }
+  void get() const {
+    state->wait();
+    state->rethrow();
+  }
+
+private:
+  mutable SharedPtr<detail::future_state<void>> state;
+};
+
+class thread_pool {
+public:
+  using task_type = mystd::unique_function<void()>;
+
+  explicit thread_pool(std::size_t threads = default_thread_count())
+      : workers(threads ? threads : 1) {
+    for (std::size_t i = 0; i < workers.size(); ++i) {
+      workers[i].rng = 0x9e3779b97f4a7c15ULL * (i + 1);
+    }
+    for (std::size_t i = 0; i < workers.size(); ++i) {
+      workers[i].thread = std::thread([this, i] { run(i); });
+    }
+  }
+  thread_pool(const thread_pool &) = delete;
+  thread_pool &operator=(const thread_pool &) = delete;
+  ~thread_pool() {
+    stopping.store(true, std::memory_order_seq_cst);
+    wake(workers.size());
+    for (worker &w : workers) {
+      w.thread.join();
+    }
+  }
+
+  static std::size_t default_thread_count() noexcept {
+    unsigned n = std::thread::hardware_concurrency();
+    return n ? n : 4;
+  }
+  std::size_t size() const noexcept { return workers.size(); }
+
+  // 不需要结果的任务
+  template <typename F> void post(F &&f) {
+    pool_task *node = new pool_task(task_type(std::forward<F>(f)));
+    enqueue(node, node, 1);
+  }
+
+  // 一批任务，*first 等元素被移动进任务里；只做一次入队和一次唤醒
+  template <typename It> void post_batch(It first, It last) {
+    pool_task *head = nullptr;
+    pool_task *tail = nullptr;
+    std::size_t count = 0;
+    try {
+      for (; first != last; ++first) {
+        auto *node = new pool_task(task_type(std::move(*first)));
+        if (tail) {
+          tail->next = node;
+        } else {
+          head = node;
+        }
+        tail = node;
+        ++count;
+      }
+    } catch (...) {
+      while (head) {
+        pool_task *next = head->next;
+        delete head;
+        head = next;
+      }
+      throw;
+    }
+    if (head) {
+      enqueue(head, tail, count);
+    }
+  }
+
+  template <typename F>
+  task_future<std::invoke_result_t<std::decay_t<F> &>> submit(F &&f) {
+    using R = std::invoke_result_t<std::decay_t<F> &>;
+    auto state = ::make_shared<detail::future_state<R>>();
+    post([state, fn = std::forward<F>(f)]() mutable { state->run(fn); });
+    return task_future<R>(std::move(state));
+  }
+
+private:
+  friend bool detail::help_current_pool();
+  using pool_task = detail::pool_task;
+
+  static constexpr int spin_rounds = 64;
+
+  struct alignas(64) worker {
+    chase_lev_deque<pool_task *> deque;
+    std::atomic<pool_task *> inbox{nullptr};
+    std::thread thread;
+    std::uint64_t rng = 0;
+  };
+
+  bool on_worker() const noexcept {
+    return detail::current_pool_context().pool == this;
+  }
+
+  // [head, tail] 是一串已经链好的任务
+  void enqueue(pool_task *head, pool_task *tail, std::size_t count) {
+    if (on_worker()) {
+      worker &self = workers[detail::current_pool_context().index];
+      for (pool_task *node = head; node;) {
+        pool_task *next = node->next;
+        node->next = nullptr;
+        self.deque.push(node);
+        node = next;
+      }
+    } else {
+      worker &target = workers[pick_inbox()];
+      pool_task *old = target.inbox.load(std::memory_order_relaxed);
+      do {
+        tail->next = old;
+      } while (!target.inbox.compare_exchange_weak(
+          old, head, std::memory_order_release, std::memory_order_relaxed));
+    }
+    // 与 park 里 sleepers 的增加配对：要么我们看到睡眠者，要么它看到任务
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleepers.load(std::memory_order_relaxed) > 0) {
+      wake(count);
+    }
+  }
+
+  // 池外线程各自轮流选择收件箱，避免所有提交者争同一个计数器
+  std::size_t pick_inbox() noexcept {
+    static thread_local std::size_t next = 0;
+    std::size_t index = next++;
+    if (index == 0) {
+      index = std::hash<std::thread::id>()(std::this_thread::get_id());
+      next = index + 1;
+    }
+    return index % workers.size();
+  }
+
+  void wake(std::size_t count) {
+    {
+      std::lock_guard<std::mutex> lock(park_mutex);
+      ++park_epoch;
+    }
+    if (count > 1) {
+      park_wakeup.notify_all();
+    } else {
+      park_wakeup.notify_one();
+    }
+  }
+
+  static std::uint64_t next_random(std::uint64_t &state) noexcept {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+  }
+
+  // 把一整串收件箱任务取到 self 的队列里，返回其中一个直接执行
+  pool_task *take_inbox(worker &from, worker &self) {
+    pool_task *list = from.inbox.exchange(nullptr, std::memory_order_acquire);
+    if (!list) {
+      return nullptr;
+    }
+    pool_task *first = list;
+    list = list->next;
+    first->next = nullptr;
+    while (list) {
+      pool_task *next = list->next;
+      list->next = nullptr;
+      self.deque.push(list);
+      list = next;
+    }
+    return first;
+  }
+
+  pool_task *find_task(std::size_t index) {
+    worker &self = workers[index];
+    if (pool_task *t = self.deque.pop()) {
+      return t;
+    }
+    if (self.inbox.load(std::memory_order_relaxed)) {
+      if (pool_task *t = take_inbox(self, self)) {
+        return t;
+      }
+    }
+    std::size_t n = workers.size();
+    std::size_t start = static_cast<std::size_t>(next_random(self.rng) % n);
+    for (std::size_t k = 0; k < n; ++k) {
+      worker &victim = workers[(start + k) % n];
+      if (&victim == &self) {
+        continue;
+      }
+      if (pool_task *t = victim.deque.steal()) {
+        return t;
+      }
+      if (victim.inbox.load(std::memory_order_relaxed)) {
+        if (pool_task *t = take_inbox(victim, self)) {
+          return t;
+        }
+      }
+    }
+    return nullptr;
+  }
+
+  bool has_work() const noexcept {
+    for (const worker &w : workers) {
+      if (!w.deque.empty() || w.inbox.load(std::memory_order_relaxed)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  static void execute(pool_task *t) noexcept {
+    t->fn();
+    delete t;
+  }
+
+  void park() {
+    std::uint64_t epoch;
+    {
+      std::lock_guard<std::mutex> lock(park_mutex);
+      epoch = park_epoch;
+    }
+    sleepers.fetch_add(1, std::memory_order_seq_cst);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!has_work() && !stopping.load(std::memory_order_relaxed)) {
+      std::unique_lock<std::mutex> lock(park_mutex);
+      park_wakeup.wait(lock, [&] {
+        return park_epoch != epoch || stopping.load(std::memory_order_relaxed);
+      });
+    }
+    sleepers.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  void run(std::size_t index) {
+    detail::current_pool_context() = {this, index};
+    int idle = 0;
+    for (;;) {
+      if (pool_task *t = find_task(index)) {
+        execute(t);
+        idle = 0;
+        continue;
+      }
+      if (stopping.load(std::memory_order_seq_cst) && !has_work()) {
+        break;
+      }
+      if (++idle < spin_rounds) {
+        std::this_thread::yield();
+        continue;
+      }
+      park();
+      idle = 0;
+    }
+    detail::current_pool_context() = {};
+  }
+
+  std::vector<worker> workers;
+  std::atomic<bool> stopping{false};
+  std::atomic<int> sleepers{0};
+  std::mutex park_mutex;
+  std::condition_variable park_wakeup;
+  std::uint64_t park_epoch = 0; // 由 park_mutex 保护
+};
+
+inline bool detail::help_current_pool() {
+  pool_context &context = current_pool_context();
+  if (pool_task *t = context.pool->find_task(context.index)) {
+    thread_pool::execute(t);
+    return true;
+  }
+  return false;
+}
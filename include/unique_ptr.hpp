@@ -1,80 +1,136 @@
+#pragma once
 #include <cassert>
+#include <cstddef>
 #include <iostream>
 #include <memory>
+#include <type_traits>
 #include <utility>
 
-template <typename T = int, typename Deleter = std::default_delete<T>>
-class unique_ptr {
+#include "ebo_storage.hpp"
+
+// unique_ptr 与 unique_ptr<T[]> 共用的部分：所有权的转移与释放。
+// 删除器经 ebo_storage 存放：默认的 std::default_delete 与无捕获 lambda 不占空间，
+// unique_ptr 只有一个指针大小。Derived 是最终的 unique_ptr 类型
+template <typename Derived, typename Element, typename Deleter>
+class unique_ptr_base : private ebo_storage<Deleter> {
  private:
-  T* source;
-  Deleter deleter;
+  using deleter_storage = ebo_storage<Deleter>;
+  Element* source;
 
  public:
-  unique_ptr() noexcept : source(nullptr), deleter() {}
-  explicit unique_ptr(T* p) : source(p), deleter() {}
-  unique_ptr(T* p, const Deleter& d) : source(p), deleter(d) {}
-  unique_ptr(T* p, Deleter&& d) : source(p), deleter(std::move(d)) {}
-  unique_ptr(unique_ptr&& other) noexcept
-      : source(other.source), deleter(std::move(other.deleter)) {
+  using element_type = Element;
+  using deleter_type = Deleter;
+
+  unique_ptr_base() noexcept : deleter_storage(), source(nullptr) {}
+  explicit unique_ptr_base(Element* p) noexcept
+      : deleter_storage(), source(p) {}
+  unique_ptr_base(Element* p, const Deleter& d)
+      : deleter_storage(d), source(p) {}
+  unique_ptr_base(Element* p, Deleter&& d)
+      : deleter_storage(std::move(d)), source(p) {}
+  unique_ptr_base(unique_ptr_base&& other) noexcept
+      : deleter_storage(std::move(other.get_deleter())), source(other.source) {
     other.source = nullptr;
   }
 
-  unique_ptr(const unique_ptr& other) = delete;
-  unique_ptr& operator=(const unique_ptr& other) = delete;
+  unique_ptr_base(const unique_ptr_base& other) = delete;
+  unique_ptr_base& operator=(const unique_ptr_base& other) = delete;
 
-  ~unique_ptr() { reset(); }
+  ~unique_ptr_base() { reset(); }
 
-  unique_ptr& operator=(unique_ptr&& other) noexcept {
+  unique_ptr_base& operator=(unique_ptr_base&& other) noexcept {
     if (this != &other) {
-      reset();
-      source = other.source;
-      deleter = std::move(other.deleter);
-      other.source = nullptr;
+      reset(other.release());
+      get_deleter() = std::move(other.get_deleter());
     }
     return *this;
   }
 
-  unique_ptr& operator=(std::nullptr_t) noexcept {
+  Derived& operator=(std::nullptr_t) noexcept {
     reset();
-    return *this;
+    return static_cast<Derived&>(*this);
   }
 
-  T* release() noexcept {
-    T* ptr = source;
+  Element* release() noexcept {
+    Element* ptr = source;
     source = nullptr;
     return ptr;
   }
 
-  void reset(T* p = nullptr) noexcept {
-    if (source != nullptr) {
-      deleter(source);
-    }
+  // 先换上新指针再删除旧对象，旧对象的析构函数再访问这个 unique_ptr 时看到的是新值
+  void reset(Element* p = nullptr) noexcept {
+    Element* old = source;
     source = p;
+    if (old != nullptr) {
+      get_deleter()(old);
+    }
   }
 
-  void swap(unique_ptr& other) noexcept {
-    std::swap(source, other.source);
-    std::swap(deleter, other.deleter);
+  void swap(Derived& other) noexcept {
+    using std::swap;
+    swap(source, other.source);
+    swap(get_deleter(), other.get_deleter());
   }
 
-  T* get() const noexcept { return source; }
-  Deleter& get_deleter() noexcept { return deleter; }
-  const Deleter& get_deleter() const noexcept { return deleter; }
+  Element* get() const noexcept { return source; }
+  Deleter& get_deleter() noexcept { return deleter_storage::get(); }
+  const Deleter& get_deleter() const noexcept { return deleter_storage::get(); }
 
   explicit operator bool() const noexcept { return source != nullptr; }
+};
+
+template <typename T = int, typename Deleter = std::default_delete<T>>
+class unique_ptr : public unique_ptr_base<unique_ptr<T, Deleter>, T, Deleter> {
+ public:
+  using unique_ptr_base<unique_ptr, T, Deleter>::unique_ptr_base;
+  using unique_ptr_base<unique_ptr, T, Deleter>::operator=;
 
   T& operator*() const {
-    assert(source != nullptr);
-    return *source;
+    assert(this->get() != nullptr);
+    return *this->get();
   }
 
   T* operator->() const {
-    assert(source != nullptr);
-    return source;
+    assert(this->get() != nullptr);
+    return this->get();
   }
 };
 
+// 数组版本：默认删除器是 std::default_delete<T[]> (delete[])，
+// 提供 operator[] 而不是 * 和 ->
+template <typename T, typename Deleter>
+class unique_ptr<T[], Deleter>
+    : public unique_ptr_base<unique_ptr<T[], Deleter>, T, Deleter> {
+ public:
+  using unique_ptr_base<unique_ptr, T, Deleter>::unique_ptr_base;
+  using unique_ptr_base<unique_ptr, T, Deleter>::operator=;
+
+  T& operator[](std::size_t i) const {
+    assert(this->get() != nullptr);
+    return this->get()[i];
+  }
+};
+
+template <typename T, typename Deleter>
+void swap(unique_ptr<T, Deleter>& lhs, unique_ptr<T, Deleter>& rhs) noexcept {
+  lhs.swap(rhs);
+}
+
+static_assert(sizeof(unique_ptr<int>) == sizeof(int*),
+              "unique_ptr with a stateless deleter must be one pointer");
+static_assert(sizeof(unique_ptr<int[]>) == sizeof(int*),
+              "unique_ptr<T[]> with a stateless deleter must be one pointer");
+
 template <typename T, typename... Args>
-unique_ptr<T> make_unique(Args&&... args) {
+std::enable_if_t<!std::is_array<T>::value, unique_ptr<T>> make_unique(
+    Args&&... args) {
   return unique_ptr<T>(new T(std::forward<Args>(args)...));
 }
+
+// make_unique<T[]>(n)：n 个值初始化的元素
+template <typename T>
+std::enable_if_t<std::is_array<T>::value && std::extent<T>::value == 0,
+                 unique_ptr<T>>
+make_unique(std::size_t n) {
+  return unique_ptr<T>(new std::remove_extent_t<T>[n]());
+}
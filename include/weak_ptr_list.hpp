@@ -0,0 +1,136 @@
+#pragma once
+#include "control_.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// 观察者列表：保存一组 WeakPtr，通知时一次遍历所有仍然存活的对象。
+//   WeakPtrList<Listener> listeners;
+//   listeners.add(listener);
+//   listeners.for_each([&](Listener &l) { l.on_event(event); });
+//
+// 与对 vector<WeakPtr> 逐个 lock() 相比：
+// - 提前 prefetch_distance 项预取控制块和对象，上万项的列表主要耗在缓存缺失上；
+// - 直接在控制块上 try_add_ref / release，不构造临时 SharedPtr；
+// - 失效项只付一次普通读 (强计数为 0 时 try_add_ref 不做 CAS)，
+//   一轮遍历里失效项超过 1/4 时顺手压缩掉，否则留到以后。
+// 容器本身不是线程安全的，add/remove/for_each 需要外部同步，回调里也不能修改同一个列表；
+// 被观察的对象可以在任何线程上销毁。
+template <typename T, typename Policy = atomic_policy> class WeakPtrList {
+  static_assert(!std::is_array<T>::value, "WeakPtrList does not hold arrays");
+
+public:
+  using weak_type = WeakPtr<T, Policy>;
+  using shared_type = SharedPtr<T, Policy>;
+
+  void add(const shared_type &p) {
+    if (shared_ptr_access::block(p)) {
+      entries.emplace_back(p);
+    }
+  }
+  void add(weak_type p) {
+    if (!p.expired()) {
+      entries.push_back(std::move(p));
+    }
+  }
+  // 移除指向 p 的项，已经失效的项一并移除
+  void remove(const T *p) {
+    entries.erase(std::remove_if(entries.begin(), entries.end(),
+                                 [p](const weak_type &w) {
+                                   return w.expired() ||
+                                          shared_ptr_access::pointer(w) == p;
+                                 }),
+                  entries.end());
+  }
+
+  // 对每个存活对象调用 f(T&)，调用期间持有它的一个强引用；返回调用次数
+  template <typename F> std::size_t for_each(F &&f) {
+    const std::size_t n = entries.size();
+    std::size_t delivered = 0;
+    std::size_t expired = 0;
+    for (std::size_t i = 0; i < n && i < prefetch_distance; ++i) {
+      prefetch(i);
+    }
+    for (std::size_t i = 0; i < n; ++i) {
+      if (i + prefetch_distance < n) {
+        prefetch(i + prefetch_distance);
+      }
+      block_type *c = shared_ptr_access::block(entries[i]);
+      if (!c->try_add_ref()) {
+        ++expired;
+        continue;
+      }
+      ref_guard guard{c};
+      f(*shared_ptr_access::pointer(entries[i]));
+      ++delivered;
+    }
+    maybe_compact(expired);
+    return delivered;
+  }
+
+  // 把所有存活对象的 SharedPtr 依次写入 out (用于需要在锁外通知的场合)
+  template <typename OutputIt> OutputIt lock_all(OutputIt out) {
+    const std::size_t n = entries.size();
+    std::size_t expired = 0;
+    for (std::size_t i = 0; i < n && i < prefetch_distance; ++i) {
+      prefetch(i);
+    }
+    for (std::size_t i = 0; i < n; ++i) {
+      if (i + prefetch_distance < n) {
+        prefetch(i + prefetch_distance);
+      }
+      block_type *c = shared_ptr_access::block(entries[i]);
+      if (!c->try_add_ref()) {
+        ++expired;
+        continue;
+      }
+      *out = shared_ptr_access::share<T, Policy>(
+          shared_ptr_access::pointer(entries[i]), c);
+      ++out;
+    }
+    maybe_compact(expired);
+    return out;
+  }
+
+  // 立刻移除所有失效项，保持其余项的顺序
+  void compact() {
+    entries.erase(std::remove_if(entries.begin(), entries.end(),
+                                 [](const weak_type &w) { return w.expired(); }),
+                  entries.end());
+  }
+  void clear() noexcept { entries.clear(); }
+  void reserve(std::size_t n) { entries.reserve(n); }
+  // 包括还没有被压缩掉的失效项
+  std::size_t size() const noexcept { return entries.size(); }
+  bool empty() const noexcept { return entries.empty(); }
+
+private:
+  using block_type = basic_control_block_base<Policy>;
+  static constexpr std::size_t prefetch_distance = 8;
+
+  // 回调抛出异常时也要把引用还回去
+  struct ref_guard {
+    block_type *ctrl;
+    ~ref_guard() { ctrl->release(); }
+  };
+
+  void prefetch(std::size_t i) const noexcept {
+#if defined(__GNUC__)
+    __builtin_prefetch(shared_ptr_access::block(entries[i]));
+    __builtin_prefetch(shared_ptr_access::pointer(entries[i]));
+#else
+    (void)i;
+#endif
+  }
+  void maybe_compact(std::size_t expired) {
+    if (expired * 4 > entries.size()) {
+      compact();
+    }
+  }
+
+  std::vector<weak_type> entries;
+};
+
+template <typename T> using LocalWeakPtrList = WeakPtrList<T, local_policy>;
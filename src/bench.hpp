@@ -0,0 +1,134 @@
+#pragma once
+// bench 目标使用的微基准小框架：多轮取最快一轮，报告 ns/op 与 allocs/op。
+// allocs/op 统计的是全局 operator new 的调用次数：主程序定义
+// BENCH_COUNT_ALLOCATIONS 后再包含本文件，由 counting_new.hpp 替换 operator new/delete
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <thread>
+#include <vector>
+
+#ifdef BENCH_COUNT_ALLOCATIONS
+#include "counting_new.hpp"
+#endif
+
+namespace bench {
+
+// 阻止编译器把被测值常量折叠或把循环整个优化掉
+template <typename T> inline void do_not_optimize(T &value) {
+  asm volatile("" : "+r,m"(value) : : "memory");
+}
+
+inline std::atomic<long> &allocations() noexcept {
+#ifdef BENCH_COUNT_ALLOCATIONS
+  return counting_new::allocations();
+#else
+  static std::atomic<long> count{0};
+  return count;
+#endif
+}
+
+struct result {
+  double ns_per_op;
+  double allocs_per_op;
+};
+
+constexpr int rounds = 5;
+
+// body(n) 执行 n 次被测操作；先预热一轮，再取 rounds 轮中最快的一轮
+template <typename Body> result measure(long iterations, Body &&body) {
+  body(iterations / 10 + 1);
+  result best{0, 0};
+  for (int round = 0; round < rounds; ++round) {
+    long allocs = allocations().load(std::memory_order_relaxed);
+    auto start = std::chrono::steady_clock::now();
+    body(iterations);
+    auto end = std::chrono::steady_clock::now();
+    allocs = allocations().load(std::memory_order_relaxed) - allocs;
+    double ns = std::chrono::duration<double, std::nano>(end - start).count() /
+                static_cast<double>(iterations);
+    if (round == 0 || ns < best.ns_per_op) {
+      best = {ns, static_cast<double>(allocs) / iterations};
+    }
+  }
+  return best;
+}
+
+// threads 个线程同时各执行 body(iterations)；ns/op 是墙钟时间除以每线程的次数，
+// 即竞争下单个线程看到的每次操作耗时
+template <typename Body>
+result measure_threads(int threads, long iterations, Body &&body) {
+  auto run = [&](long n) {
+    std::atomic<int> ready(0);
+    std::atomic<bool> go(false);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+      workers.emplace_back([&]() {
+        ready.fetch_add(1);
+        while (!go.load()) {
+        }
+        body(n);
+      });
+    }
+    while (ready.load() != threads) {
+    }
+    long allocs = allocations().load(std::memory_order_relaxed);
+    auto start = std::chrono::steady_clock::now();
+    go.store(true);
+    for (auto &w : workers) {
+      w.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+    allocs = allocations().load(std::memory_order_relaxed) - allocs;
+    return result{
+        std::chrono::duration<double, std::nano>(end - start).count() / n,
+        static_cast<double>(allocs) / (static_cast<double>(n) * threads)};
+  };
+  run(iterations / 10 + 1);
+  result best{0, 0};
+  for (int round = 0; round < rounds; ++round) {
+    result r = run(iterations);
+    if (round == 0 || r.ns_per_op < best.ns_per_op) {
+      best = r;
+    }
+  }
+  return best;
+}
+
+// 按名字子串过滤并打印结果
+class suite {
+public:
+  explicit suite(const char *filter) : filter(filter ? filter : "") {}
+
+  bool enabled(const char *name) const {
+    return filter[0] == '\0' || std::strstr(name, filter) != nullptr;
+  }
+  void section(const char *title) const { std::printf("\n%s\n", title); }
+  template <typename Body>
+  void run(const char *name, long iterations, Body &&body) const {
+    if (enabled(name)) {
+      report(name, measure(iterations, body));
+    }
+  }
+  template <typename Body>
+  void run_threads(const char *name, int threads, long iterations,
+                   Body &&body) const {
+    if (enabled(name)) {
+      report(name, measure_threads(threads, iterations, body));
+    }
+  }
+  static void report(const char *name, const result &r) {
+    std::printf("  %-44s %10.2f ns/op %8.3f allocs/op\n", name, r.ns_per_op,
+                r.allocs_per_op);
+  }
+
+private:
+  const char *filter;
+};
+
+} // namespace bench
+
@@ -0,0 +1,743 @@
+// SharedPtr / WeakPtr / mystd::function / unique_ptr 与标准库对应物的微基准
+// 构建: cmake --build <build 目录> --target bench
+// 用法: ./bench [名字过滤子串] [最大线程数]
+#define BENCH_COUNT_ALLOCATIONS
+#include "bench.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+
+#include "atomic_shared_ptr.hpp"
+#include "biased_policy.hpp"
+#include "control_.hpp"
+#include "cycle_collector.hpp"
+#include "func.hpp"
+#include "hybrid_policy.hpp"
+#include "object_pool.hpp"
+#include "padded_policy.hpp"
+#include "thread_pool.hpp"
+#include "unique_ptr.hpp"
+#include "weak_ptr_list.hpp"
+
+namespace {
+
+struct Payload {
+  long value[2] = {1, 2};
+};
+
+// 在一个不内联的函数里构造，避免编译器看穿被擦除的类型直接内联调用
+__attribute__((noinline)) int add_one(int x) { return x + 1; }
+template <typename Fn> __attribute__((noinline)) Fn make_callable() {
+  return Fn(&add_one);
+}
+template <typename Fn> __attribute__((noinline)) Fn make_stateful(int *base) {
+  return Fn([base](int x) { return x + *base; });
+}
+
+// 大小为 N 字节的可调用对象，用来观察小缓冲区装不下时的分配
+template <std::size_t N> struct sized_callable {
+  unsigned char data[N] = {1};
+  int operator()(int x) const { return x + data[0]; }
+};
+
+std::vector<int> thread_counts(int max_threads) {
+  std::vector<int> counts;
+  for (int threads = 1; threads < max_threads; threads *= 2) {
+    counts.push_back(threads);
+  }
+  counts.push_back(max_threads);
+  return counts;
+}
+
+std::string label(const char *name, int threads) {
+  return std::string(name) + " x" + std::to_string(threads);
+}
+
+void bench_construct(const bench::suite &s) {
+  s.section("构造 + 析构");
+  const long n = 1000000;
+  s.run("SharedPtr(new T)", n, [](long iterations) {
+    for (long i = 0; i < iterations; ++i) {
+      SharedPtr<Payload> p(new Payload);
+      bench::do_not_optimize(p);
+    }
+  });
+  s.run("std::shared_ptr(new T)", n, [](long iterations) {
+    for (long i = 0; i < iterations; ++i) {
+      std::shared_ptr<Payload> p(new Payload);
+      bench::do_not_optimize(p);
+    }
+  });
+  s.run("make_shared", n, [](long iterations) {
+    for (long i = 0; i < iterations; ++i) {
+      auto p = ::make_shared<Payload>();
+      bench::do_not_optimize(p);
+    }
+  });
+  s.run("std::make_shared", n, [](long iterations) {
+    for (long i = 0; i < iterations; ++i) {
+      auto p = std::make_shared<Payload>();
+      bench::do_not_optimize(p);
+    }
+  });
+  s.run("make_unique", n, [](long iterations) {
+    for (long i = 0; i < iterations; ++i) {
+      auto p = ::make_unique<Payload>();
+      bench::do_not_optimize(p);
+    }
+  });
+  s.run("std::make_unique", n, [](long iterations) {
+    for (long i = 0; i < iterations; ++i) {
+      auto p = std::make_unique<Payload>();
+      bench::do_not_optimize(p);
+    }
+  });
+}
+
+// 所有线程反复拷贝并销毁同一个对象；对象由主线程创建，
+// 所以 biased_policy 下工作线程走的都是分片槽位
+void bench_copy(const bench::suite &s, int max_threads) {
+  s.section("拷贝 + 析构同一个对象 (x 线程数)");
+  const long n = 2000000;
+  SharedPtr<Payload> mine = ::make_shared<Payload>();
+  BiasedSharedPtr<Payload> biased = make_biased_shared<Payload>();
+  std::shared_ptr<Payload> theirs = std::make_shared<Payload>();
+  for (int threads : thread_counts(max_threads)) {
+    s.run_threads(label("copy SharedPtr", threads).c_str(), threads, n,
+                  [&](long iterations) {
+                    for (long i = 0; i < iterations; ++i) {
+                      SharedPtr<Payload> copy = mine;
+                      bench::do_not_optimize(copy);
+                    }
+                  });
+    s.run_threads(label("copy BiasedSharedPtr", threads).c_str(), threads, n,
+                  [&](long iterations) {
+                    for (long i = 0; i < iterations; ++i) {
+                      BiasedSharedPtr<Payload> copy = biased;
+                      bench::do_not_optimize(copy);
+                    }
+                  });
+    s.run_threads(label("copy std::shared_ptr", threads).c_str(), threads, n,
+                  [&](long iterations) {
+                    for (long i = 0; i < iterations; ++i) {
+                      std::shared_ptr<Payload> copy = theirs;
+                      bench::do_not_optimize(copy);
+                    }
+                  });
+  }
+}
+
+struct Config {
+  long version;
+  long payload[7];
+  explicit Config(long v) : version(v), payload{} {}
+};
+
+struct MutexSlot {
+  mutable std::mutex mutex;
+  SharedPtr<Config> value;
+  SharedPtr<Config> load() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return value;
+  }
+  void store(SharedPtr<Config> p) {
+    std::lock_guard<std::mutex> lock(mutex);
+    value = std::move(p);
+  }
+  static SharedPtr<Config> make(long v) { return ::make_shared<Config>(v); }
+};
+
+// C++17 没有 std::atomic<std::shared_ptr>，用等价的 std::atomic_load/atomic_store
+struct StdAtomicSlot {
+  std::shared_ptr<Config> value;
+  std::shared_ptr<Config> load() const { return std::atomic_load(&value); }
+  void store(std::shared_ptr<Config> p) { std::atomic_store(&value, p); }
+  static std::shared_ptr<Config> make(long v) {
+    return std::make_shared<Config>(v);
+  }
+};
+
+struct AtomicSharedSlot {
+  AtomicSharedPtr<Config> value;
+  SharedPtr<Config> load() const { return value.load(); }
+  void store(SharedPtr<Config> p) { value.store(std::move(p)); }
+  static SharedPtr<Config> make(long v) { return ::make_shared<Config>(v); }
+};
+
+// 读线程不停地取快照并读一下内容，同时有一个写线程每 50us 发布新快照
+template <typename Slot>
+void time_snapshots(const bench::suite &s, const char *name, int threads) {
+  std::string full = label(name, threads);
+  if (!s.enabled(full.c_str())) {
+    return;
+  }
+  Slot slot;
+  slot.store(Slot::make(0));
+  std::atomic<bool> stop(false);
+  std::thread writer([&] {
+    for (long version = 1; !stop.load(std::memory_order_relaxed); ++version) {
+      slot.store(Slot::make(version));
+      std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+  });
+  s.run_threads(full.c_str(), threads, 1000000, [&](long iterations) {
+    long sum = 0;
+    for (long i = 0; i < iterations; ++i) {
+      auto snapshot = slot.load();
+      sum += snapshot->version;
+    }
+    bench::do_not_optimize(sum);
+  });
+  stop.store(true);
+  writer.join();
+}
+
+void bench_snapshots(const bench::suite &s, int max_threads) {
+  s.section("读取共享快照 + 1 个写线程 (x 读线程数)");
+  for (int threads : thread_counts(max_threads)) {
+    time_snapshots<MutexSlot>(s, "load mutex + SharedPtr", threads);
+    time_snapshots<StdAtomicSlot>(s, "load std::atomic_load(shared_ptr)",
+                                  threads);
+    time_snapshots<AtomicSharedSlot>(s, "load AtomicSharedPtr", threads);
+  }
+}
+
+// 只在创建线程上拷贝：混合计数升级前应与 local_policy 相当，升级后与 atomic_policy 相当
+template <typename Policy>
+void time_owner_copies(const bench::suite &s, const char *name,
+                       bool promote = false) {
+  SharedPtr<Payload, Policy> p = basic_make_shared<Payload, Policy>();
+  if (promote) {
+    shared_ptr_access::block(p)->share_across_threads();
+  }
+  s.run(name, 20000000, [&](long iterations) {
+    for (long i = 0; i < iterations; ++i) {
+      SharedPtr<Payload, Policy> copy = p;
+      bench::do_not_optimize(copy);
+    }
+  });
+}
+
+void bench_policies(const bench::suite &s) {
+  s.section("单线程拷贝 + 析构 (计数策略)");
+  time_owner_copies<local_policy>(s, "local_policy");
+  time_owner_copies<hybrid_policy>(s, "hybrid_policy (owner thread)");
+  time_owner_copies<hybrid_policy>(s, "hybrid_policy (promoted)", true);
+  time_owner_copies<atomic_policy>(s, "atomic_policy");
+}
+
+void bench_lock(const bench::suite &s, int max_threads) {
+  s.section("WeakPtr::lock() + 析构 (x 线程数)");
+  const long n = 2000000;
+  SharedPtr<Payload> mine = ::make_shared<Payload>();
+  WeakPtr<Payload> mine_weak(mine);
+  std::shared_ptr<Payload> theirs = std::make_shared<Payload>();
+  std::weak_ptr<Payload> theirs_weak(theirs);
+  for (int threads : thread_counts(max_threads)) {
+    s.run_threads(label("WeakPtr::lock", threads).c_str(), threads, n,
+                  [&](long iterations) {
+                    WeakPtr<Payload> weak = mine_weak;
+                    for (long i = 0; i < iterations; ++i) {
+                      SharedPtr<Payload> locked = weak.lock();
+                      bench::do_not_optimize(locked);
+                    }
+                  });
+    s.run_threads(label("std::weak_ptr::lock", threads).c_str(), threads, n,
+                  [&](long iterations) {
+                    std::weak_ptr<Payload> weak = theirs_weak;
+                    for (long i = 0; i < iterations; ++i) {
+                      std::shared_ptr<Payload> locked = weak.lock();
+                      bench::do_not_optimize(locked);
+                    }
+                  });
+  }
+}
+
+// 短命消息对象：每次都新建 vs 从 ObjectPool 取出并在释放时回收
+void bench_pool(const bench::suite &s) {
+  s.section("消息对象: 获取 + 释放");
+  const long n = 1000000;
+  ObjectPool<Payload> pool(64);
+  ObjectPool<Payload> reset_pool(64, [](Payload &p) { p.value[0] = 1; });
+  s.run("make_shared message", n, [](long iterations) {
+    for (long i = 0; i < iterations; ++i) {
+      auto p = ::make_shared<Payload>();
+      bench::do_not_optimize(p);
+    }
+  });
+  s.run("std::make_shared message", n, [](long iterations) {
+    for (long i = 0; i < iterations; ++i) {
+      auto p = std::make_shared<Payload>();
+      bench::do_not_optimize(p);
+    }
+  });
+  s.run("ObjectPool::acquire", n, [&](long iterations) {
+    for (long i = 0; i < iterations; ++i) {
+      SharedPtr<Payload> p = pool.acquire();
+      bench::do_not_optimize(p);
+    }
+  });
+  s.run("ObjectPool::acquire (reset hook)", n, [&](long iterations) {
+    for (long i = 0; i < iterations; ++i) {
+      SharedPtr<Payload> p = reset_pool.acquire();
+      bench::do_not_optimize(p);
+    }
+  });
+  s.run("ObjectPool::acquire_unique", n, [&](long iterations) {
+    for (long i = 0; i < iterations; ++i) {
+      ObjectPool<Payload>::unique_type p = pool.acquire_unique();
+      bench::do_not_optimize(p);
+    }
+  });
+}
+
+// 线程轮流担任三种角色：拷贝 SharedPtr (强计数)、拷贝 WeakPtr (弱计数)、
+// 写 make_shared 的对象本身。紧凑布局下三者在同一条缓存行上
+template <typename Policy>
+void time_layout(const bench::suite &s, const char *name, int threads) {
+  SharedPtr<Payload, Policy> shared = basic_make_shared<Payload, Policy>();
+  WeakPtr<Payload, Policy> weak(shared);
+  Payload *object = shared.get();
+  std::atomic<int> next_role(0);
+  s.run_threads(label(name, threads).c_str(), threads, 2000000,
+                [&](long iterations) {
+                  int role = next_role.fetch_add(1) % 3;
+                  for (long i = 0; i < iterations; ++i) {
+                    if (role == 0) {
+                      SharedPtr<Payload, Policy> copy = shared;
+                      bench::do_not_optimize(copy);
+                    } else if (role == 1) {
+                      WeakPtr<Payload, Policy> copy = weak;
+                      bench::do_not_optimize(copy);
+                    } else {
+                      ++object->value[0];
+                      bench::do_not_optimize(object->value[0]);
+                    }
+                  }
+                });
+}
+
+void bench_layout(const bench::suite &s, int max_threads) {
+  s.section("控制块布局: 拷贝 SharedPtr / 拷贝 WeakPtr / 写对象 (x 线程数)");
+  std::printf("  sizeof: compact make_shared block = %zu, padded = %zu\n",
+              sizeof(control_block_inplace<Payload>),
+              sizeof(control_block_inplace<Payload, padded_policy<>>));
+  for (int threads : thread_counts(std::max(3, max_threads))) {
+    if (threads < 3) {
+      continue;
+    }
+    time_layout<atomic_policy>(s, "compact layout", threads);
+    time_layout<padded_policy<>>(s, "padded layout", threads);
+  }
+}
+
+// 对照组：一个全局队列 + mutex + condition_variable 的线程池
+class mutex_queue_pool {
+public:
+  explicit mutex_queue_pool(int threads) {
+    for (int i = 0; i < threads; ++i) {
+      workers.emplace_back([this] { run(); });
+    }
+  }
+  ~mutex_queue_pool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+    ready.notify_all();
+    for (std::thread &t : workers) {
+      t.join();
+    }
+  }
+  void post(mystd::unique_function<void()> task) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      tasks.push_back(std::move(task));
+    }
+    ready.notify_one();
+  }
+  template <typename It> void post_batch(It first, It last) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      for (; first != last; ++first) {
+        tasks.push_back(std::move(*first));
+      }
+    }
+    ready.notify_all();
+  }
+
+private:
+  void run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+      ready.wait(lock, [this] { return stopping || !tasks.empty(); });
+      if (tasks.empty()) {
+        return;
+      }
+      mystd::unique_function<void()> task = std::move(tasks.front());
+      tasks.pop_front();
+      lock.unlock();
+      task();
+      lock.lock();
+    }
+  }
+
+  std::mutex mutex;
+  std::condition_variable ready;
+  std::deque<mystd::unique_function<void()>> tasks;
+  bool stopping = false;
+  std::vector<std::thread> workers;
+};
+
+void wait_for_count(const std::atomic<long> &done, long target) {
+  while (done.load(std::memory_order_acquire) < target) {
+    std::this_thread::yield();
+  }
+}
+
+// 主线程投递 iterations 个极小的任务，等它们全部执行完
+template <typename Pool>
+void time_pool_post(const bench::suite &s, const char *name, Pool &pool,
+                    int threads) {
+  std::atomic<long> done{0};
+  s.run(label(name, threads).c_str(), 200000, [&](long iterations) {
+    done.store(0, std::memory_order_relaxed);
+    for (long i = 0; i < iterations; ++i) {
+      pool.post([&done] { done.fetch_add(1, std::memory_order_release); });
+    }
+    wait_for_count(done, iterations);
+  });
+}
+
+// 每 256 个任务一批投递
+template <typename Pool>
+void time_pool_batch(const bench::suite &s, const char *name, Pool &pool,
+                     int threads) {
+  std::atomic<long> done{0};
+  std::vector<mystd::unique_function<void()>> batch;
+  s.run(label(name, threads).c_str(), 200000, [&](long iterations) {
+    done.store(0, std::memory_order_relaxed);
+    for (long i = 0; i < iterations;) {
+      batch.clear();
+      for (; i < iterations && batch.size() < 256; ++i) {
+        batch.emplace_back(
+            [&done] { done.fetch_add(1, std::memory_order_release); });
+      }
+      pool.post_batch(batch.begin(), batch.end());
+    }
+    wait_for_count(done, iterations);
+  });
+}
+
+long pool_sum(thread_pool &pool, long first, long last) {
+  if (last - first <= 64) {
+    long sum = 0;
+    for (long i = first; i < last; ++i) {
+      sum += i;
+    }
+    return sum;
+  }
+  long middle = first + (last - first) / 2;
+  task_future<long> left = pool.submit(
+      [&pool, first, middle] { return pool_sum(pool, first, middle); });
+  long right = pool_sum(pool, middle, last);
+  return left.get() + right;
+}
+
+void bench_thread_pool(const bench::suite &s, int max_threads) {
+  s.section("线程池: 投递极小的任务 (x 工作线程数)");
+  for (int threads : thread_counts(max_threads)) {
+    {
+      mutex_queue_pool pool(threads);
+      time_pool_post(s, "mutex queue post", pool, threads);
+      time_pool_batch(s, "mutex queue post_batch", pool, threads);
+    }
+    thread_pool pool(static_cast<std::size_t>(threads));
+    time_pool_post(s, "thread_pool post", pool, threads);
+    time_pool_batch(s, "thread_pool post_batch", pool, threads);
+    // 每个叶子 64 个元素，ns/op 按元素计
+    s.run(label("thread_pool fork-join submit", threads).c_str(), 1 << 20,
+          [&](long iterations) {
+            task_future<long> root = pool.submit(
+                [&pool, iterations] { return pool_sum(pool, 0, iterations); });
+            long sum = root.get();
+            bench::do_not_optimize(sum);
+          });
+  }
+}
+
+template <typename Fn>
+void time_calls(const bench::suite &s, const char *name, const Fn &fn) {
+  s.run(name, 50000000, [&](long iterations) {
+    int acc = 0;
+    for (long i = 0; i < iterations; ++i) {
+      acc = fn(acc);
+      bench::do_not_optimize(acc);
+    }
+  });
+}
+
+template <typename Fn, std::size_t N>
+void time_function_construct(const bench::suite &s, const char *name) {
+  std::string full = std::string(name) + " " + std::to_string(N) + "B";
+  s.run(full.c_str(), 1000000, [](long iterations) {
+    for (long i = 0; i < iterations; ++i) {
+      Fn fn(sized_callable<N>{});
+      bench::do_not_optimize(fn);
+    }
+  });
+}
+
+template <std::size_t N> void bench_function_size(const bench::suite &s) {
+  time_function_construct<std::function<int(int)>, N>(s, "std::function");
+  time_function_construct<mystd::function<int(int)>, N>(s, "mystd::function");
+}
+
+void bench_function(const bench::suite &s) {
+  s.section("function 调用 (函数指针目标)");
+  int (*volatile raw_ptr)(int) = &add_one;
+  int (*raw)(int) = raw_ptr;
+  time_calls(s, "raw function pointer", raw);
+  time_calls(s, "std::function call",
+             make_callable<std::function<int(int)>>());
+  time_calls(s, "mystd::function call",
+             make_callable<mystd::function<int(int)>>());
+
+  s.section("function 调用 (带捕获的 lambda 目标)");
+  int base = 1;
+  time_calls(s, "std::function call (lambda)",
+             make_stateful<std::function<int(int)>>(&base));
+  time_calls(s, "mystd::function call (lambda)",
+             make_stateful<mystd::function<int(int)>>(&base));
+
+  s.section("function 构造 + 析构 (按可调用对象大小)");
+  bench_function_size<8>(s);
+  bench_function_size<24>(s);
+  bench_function_size<32>(s);
+  bench_function_size<64>(s);
+  bench_function_size<128>(s);
+}
+
+struct Listener {
+  long events = 0;
+};
+
+// 10k 个监听者，打乱顺序以免遍历顺序与分配顺序一致；其中 1/8 已经失效。
+// ns/op 为每个监听者
+void bench_observers(const bench::suite &s) {
+  s.section("通知 10k 个监听者 (WeakPtr 观察者列表)");
+  const std::size_t count = 10000;
+  std::vector<SharedPtr<Listener>> mine;
+  std::vector<std::shared_ptr<Listener>> theirs;
+  for (std::size_t i = 0; i < count; ++i) {
+    mine.push_back(::make_shared<Listener>());
+    theirs.push_back(std::make_shared<Listener>());
+  }
+  std::mt19937 rng(42);
+  std::shuffle(mine.begin(), mine.end(), rng);
+  std::shuffle(theirs.begin(), theirs.end(), rng);
+  std::vector<WeakPtr<Listener>> weak_vector;
+  WeakPtrList<Listener> weak_list;
+  std::vector<std::weak_ptr<Listener>> std_vector;
+  for (std::size_t i = 0; i < count; ++i) {
+    weak_vector.emplace_back(mine[i]);
+    weak_list.add(mine[i]);
+    std_vector.emplace_back(theirs[i]);
+  }
+  for (std::size_t i = 0; i < count; i += 8) {
+    mine[i] = nullptr;
+    theirs[i] = nullptr;
+  }
+  const long n = 200 * count;
+  s.run("vector<WeakPtr> lock loop", n, [&](long iterations) {
+    for (long done = 0; done < iterations; done += count) {
+      for (WeakPtr<Listener> &w : weak_vector) {
+        if (SharedPtr<Listener> l = w.lock()) {
+          ++l->events;
+        }
+      }
+    }
+  });
+  s.run("WeakPtrList::for_each", n, [&](long iterations) {
+    for (long done = 0; done < iterations; done += count) {
+      weak_list.for_each([](Listener &l) { ++l.events; });
+    }
+  });
+  s.run("vector<std::weak_ptr> lock loop", n, [&](long iterations) {
+    for (long done = 0; done < iterations; done += count) {
+      for (std::weak_ptr<Listener> &w : std_vector) {
+        if (std::shared_ptr<Listener> l = w.lock()) {
+          ++l->events;
+        }
+      }
+    }
+  });
+}
+
+struct Node {
+  long value = 1;
+  long padding[3] = {};
+};
+
+// 顺序访问 vector 中每个 unique_ptr 指向的节点，ns/op 为每个元素
+template <typename Ptr, typename Make>
+void time_traversal(const bench::suite &s, const char *name, Make make) {
+  const std::size_t count = 1 << 16;
+  std::vector<Ptr> nodes;
+  nodes.reserve(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    nodes.push_back(make());
+  }
+  s.run(name, 200 * count, [&](long iterations) {
+    long sum = 0;
+    for (long done = 0; done < iterations; done += count) {
+      for (const Ptr &p : nodes) {
+        sum += p->value;
+      }
+      bench::do_not_optimize(sum);
+    }
+  });
+}
+
+struct GraphNode {
+  SharedPtr<GraphNode> next;
+  void trace(cycle_tracer &t) { t(next); }
+};
+
+// 建 n 个节点，每 8 个连成一个环 (ring = true) 或一条链，只返回每组的头
+std::vector<SharedPtr<GraphNode>> build_groups(cycle_collector &gc, long n,
+                                               bool ring) {
+  std::vector<SharedPtr<GraphNode>> heads;
+  for (long i = 0; i < n; i += 8) {
+    SharedPtr<GraphNode> head = make_collectable<GraphNode>(gc);
+    SharedPtr<GraphNode> tail = head;
+    for (long j = i + 1; j < std::min(n, i + 8); ++j) {
+      tail->next = make_collectable<GraphNode>(gc);
+      tail = tail->next;
+    }
+    if (ring) {
+      tail->next = head;
+    }
+    heads.push_back(std::move(head));
+  }
+  return heads;
+}
+
+// 分步回收完成一轮时单次 step 的最长耗时；垃圾按组 (这里是一个环) 校验，
+// 析构按预算分批，每步的工作量有上限，最长耗时不随图的大小成比例增长
+// (大图上只多出缓存未命中，100k 节点比 1k 慢不到一倍)。
+// build(gc) 建图并返回要保留的引用。每轮的 step 序列相同，与其他项一样
+// 逐个 step 取 rounds 轮中最快的一次，免得调度噪声随 step 数一起增长
+template <typename Build>
+void print_longest_step(const bench::suite &s, const char *kind, long n,
+                        Build &&build) {
+  std::string name = std::string("step(1024) over ") + kind + " rings";
+  if (!s.enabled(name.c_str())) {
+    return;
+  }
+  std::vector<double> fastest;
+  for (int round = 0; round < bench::rounds; ++round) {
+    cycle_collector gc;
+    std::vector<SharedPtr<GraphNode>> kept = build(gc);
+    for (std::size_t i = 0;; ++i) {
+      auto start = std::chrono::steady_clock::now();
+      bool finished = gc.step(1024);
+      std::chrono::duration<double, std::micro> took =
+          std::chrono::steady_clock::now() - start;
+      if (i == fastest.size()) {
+        fastest.push_back(took.count());
+      }
+      fastest[i] = std::min(fastest[i], took.count());
+      if (finished) {
+        break;
+      }
+    }
+  }
+  std::printf("  %s %ld: %zu steps, longest %.1f us\n", name.c_str(), n,
+              fastest.size(),
+              *std::max_element(fastest.begin(), fastest.end()));
+}
+
+// ns/op 均按节点计
+void bench_cycles(const bench::suite &s) {
+  s.section("循环回收: 按图大小 (ns/op 为每个节点)");
+  for (long n : {1000L, 10000L, 100000L}) {
+    std::string size = " " + std::to_string(n);
+    {
+      cycle_collector gc;
+      std::vector<SharedPtr<GraphNode>> heads = build_groups(gc, n, true);
+      s.run(("collect live rings" + size).c_str(), n, [&](long iterations) {
+        for (long done = 0; done < iterations; done += n) {
+          gc.collect();
+        }
+      });
+    }
+    print_longest_step(s, "live", n, [n](cycle_collector &gc) {
+      return build_groups(gc, n, true);
+    });
+    print_longest_step(s, "garbage", n, [n](cycle_collector &gc) {
+      build_groups(gc, n, true);
+      return std::vector<SharedPtr<GraphNode>>();
+    });
+    s.run(("build + drop chains (rc)" + size).c_str(), n,
+          [&](long iterations) {
+            cycle_collector gc;
+            build_groups(gc, iterations, false);
+          });
+    s.run(("build + drop + collect rings" + size).c_str(), n,
+          [&](long iterations) {
+            cycle_collector gc;
+            build_groups(gc, iterations, true);
+            gc.collect();
+          });
+  }
+}
+
+void bench_unique(const bench::suite &s) {
+  s.section("vector<unique_ptr<Node>> 遍历");
+  std::printf("  sizeof(unique_ptr<Node>) = %zu, sizeof(std::unique_ptr<Node>) "
+              "= %zu\n",
+              sizeof(::unique_ptr<Node>), sizeof(std::unique_ptr<Node>));
+  time_traversal<::unique_ptr<Node>>(s, "unique_ptr traversal",
+                                     [] { return ::make_unique<Node>(); });
+  time_traversal<std::unique_ptr<Node>>(s, "std::unique_ptr traversal", [] {
+    return std::make_unique<Node>();
+  });
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  bench::suite s(argc > 1 ? argv[1] : "");
+  int max_threads = argc > 2 ? std::atoi(argv[2]) : 0;
+  if (max_threads <= 0) {
+    max_threads = static_cast<int>(std::thread::hardware_concurrency());
+  }
+  if (max_threads <= 0) {
+    max_threads = 4;
+  }
+  std::printf("每项 %d 轮取最快一轮, 最大线程数 %d\n", bench::rounds,
+              max_threads);
+  bench_construct(s);
+  bench_copy(s, max_threads);
+  bench_snapshots(s, max_threads);
+  bench_policies(s);
+  bench_lock(s, max_threads);
+  bench_observers(s);
+  bench_layout(s, max_threads);
+  bench_pool(s);
+  bench_thread_pool(s, max_threads);
+  bench_function(s);
+  bench_unique(s);
+  bench_cycles(s);
+  return 0;
+}
@@ -0,0 +1,127 @@
+#pragma once
+// 测试与基准共用：替换全局 operator new/delete，统计 operator new 的调用次数，
+// 用来确认某条路径没有堆分配。替换函数是非 inline 的全局定义，
+// 整个程序只能有一个翻译单元包含本文件。
+//
+// 替换的是完整的一组：普通/数组、nothrow 与按对齐的 new，以及对应的普通、
+// 带大小、按对齐与 nothrow 的 delete，全部经 malloc/aligned_alloc 与 free。
+// 替换函数不内联：否则 g++ 在调用方看到 new 表达式得到的指针被直接 free，
+// 报 -Wmismatched-new-delete
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace counting_new {
+
+inline std::atomic<long> &allocations() noexcept {
+  static std::atomic<long> count{0};
+  return count;
+}
+
+inline void *allocate(std::size_t size) noexcept {
+  allocations().fetch_add(1, std::memory_order_relaxed);
+  return std::malloc(size ? size : 1);
+}
+
+// aligned_alloc 要求大小是对齐的整数倍
+inline void *allocate(std::size_t size, std::align_val_t align) noexcept {
+  allocations().fetch_add(1, std::memory_order_relaxed);
+  std::size_t alignment = static_cast<std::size_t>(align);
+  std::size_t rounded = (size + alignment - 1) / alignment * alignment;
+  return std::aligned_alloc(alignment, rounded ? rounded : alignment);
+}
+
+inline void *allocate_or_throw(std::size_t size) {
+  if (void *p = allocate(size)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+inline void *allocate_or_throw(std::size_t size, std::align_val_t align) {
+  if (void *p = allocate(size, align)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+} // namespace counting_new
+
+#define COUNTING_NEW_NOINLINE __attribute__((noinline))
+
+COUNTING_NEW_NOINLINE void *operator new(std::size_t size) {
+  return counting_new::allocate_or_throw(size);
+}
+COUNTING_NEW_NOINLINE void *operator new[](std::size_t size) {
+  return counting_new::allocate_or_throw(size);
+}
+COUNTING_NEW_NOINLINE void *operator new(std::size_t size,
+                                         const std::nothrow_t &) noexcept {
+  return counting_new::allocate(size);
+}
+COUNTING_NEW_NOINLINE void *operator new[](std::size_t size,
+                                           const std::nothrow_t &) noexcept {
+  return counting_new::allocate(size);
+}
+COUNTING_NEW_NOINLINE void *operator new(std::size_t size,
+                                         std::align_val_t align) {
+  return counting_new::allocate_or_throw(size, align);
+}
+COUNTING_NEW_NOINLINE void *operator new[](std::size_t size,
+                                           std::align_val_t align) {
+  return counting_new::allocate_or_throw(size, align);
+}
+COUNTING_NEW_NOINLINE void *operator new(std::size_t size,
+                                         std::align_val_t align,
+                                         const std::nothrow_t &) noexcept {
+  return counting_new::allocate(size, align);
+}
+COUNTING_NEW_NOINLINE void *operator new[](std::size_t size,
+                                           std::align_val_t align,
+                                           const std::nothrow_t &) noexcept {
+  return counting_new::allocate(size, align);
+}
+
+COUNTING_NEW_NOINLINE void operator delete(void *p) noexcept { std::free(p); }
+COUNTING_NEW_NOINLINE void operator delete[](void *p) noexcept {
+  std::free(p);
+}
+COUNTING_NEW_NOINLINE void operator delete(void *p, std::size_t) noexcept {
+  std::free(p);
+}
+COUNTING_NEW_NOINLINE void operator delete[](void *p, std::size_t) noexcept {
+  std::free(p);
+}
+COUNTING_NEW_NOINLINE void operator delete(void *p,
+                                           const std::nothrow_t &) noexcept {
+  std::free(p);
+}
+COUNTING_NEW_NOINLINE void operator delete[](void *p,
+                                             const std::nothrow_t &) noexcept {
+  std::free(p);
+}
+COUNTING_NEW_NOINLINE void operator delete(void *p, std::align_val_t) noexcept {
+  std::free(p);
+}
+COUNTING_NEW_NOINLINE void operator delete[](void *p,
+                                             std::align_val_t) noexcept {
+  std::free(p);
+}
+COUNTING_NEW_NOINLINE void operator delete(void *p, std::size_t,
+                                           std::align_val_t) noexcept {
+  std::free(p);
+}
+COUNTING_NEW_NOINLINE void operator delete[](void *p, std::size_t,
+                                             std::align_val_t) noexcept {
+  std::free(p);
+}
+COUNTING_NEW_NOINLINE void operator delete(void *p, std::align_val_t,
+                                           const std::nothrow_t &) noexcept {
+  std::free(p);
+}
+COUNTING_NEW_NOINLINE void operator delete[](void *p, std::align_val_t,
+                                             const std::nothrow_t &) noexcept {
+  std::free(p);
+}
+
+#undef COUNTING_NEW_NOINLINE
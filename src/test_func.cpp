@@ -5,10 +5,17 @@
 #include <memory>
 #include <vector>
 #include <type_traits>
+#include <cstdlib>
+#include <new>
 
 // 引入我们自己的function实现
 #include "func.hpp"
 
+// 统计全局 operator new 的调用次数，用来确认小对象没有走堆分配
+#include "counting_new.hpp"
+
+static long allocations() { return counting_new::allocations().load(); }
+
 // 测试用的简单函数
 int add(int a, int b) {
     return a + b;
@@ -79,6 +86,20 @@ void test_basic_functionality() {
     assert(f7);
     assert(f7(5) == 15);
     std::cout << "带状态的函数对象测试通过" << std::endl;
+
+    // 测试 mutable lambda：被存储的对象以非 const 方式调用，状态会保留
+    mystd::function<int()> f8 = [n = 0]() mutable { return ++n; };
+    assert(f8() == 1 && f8() == 2);
+    mystd::function<int()> f9 = f8; // 拷贝的是当前状态
+    assert(f9() == 3 && f8() == 3);
+    std::cout << "mutable Lambda测试通过" << std::endl;
+
+    // 测试 void 返回类型丢弃可调用对象的返回值
+    int calls = 0;
+    mystd::function<void()> f10 = [&calls]() { return ++calls; };
+    f10();
+    assert(calls == 1);
+    std::cout << "void返回类型测试通过" << std::endl;
 }
 
 // 测试拷贝和移动语义
@@ -189,6 +210,71 @@ void test_large_callables() {
     
     assert(actual == expected);
     std::cout << "大型可调用对象测试通过" << std::endl;
+
+    // 超出内联缓冲区的对象必须走堆分配
+    long before = allocations();
+    mystd::function<int(int)> f_heap = large;
+    assert(allocations() == before + 1);
+    assert(f_heap(5) == expected);
+    // 移动只转移指针，不再分配
+    before = allocations();
+    mystd::function<int(int)> f_heap_moved = std::move(f_heap);
+    assert(allocations() == before);
+    assert(!f_heap && f_heap_moved(5) == expected);
+    std::cout << "大型对象堆存储测试通过" << std::endl;
+
+    // 函数指针、无捕获 lambda、捕获 3 个指针的 lambda 都应内联存储
+    int a = 1, b = 2, c = 3;
+    before = allocations();
+    mystd::function<int(int, int)> f_ptr = add;
+    mystd::function<int(int)> f_empty = [](int x) { return x + 1; };
+    mystd::function<int(int)> f_three = [pa = &a, pb = &b, pc = &c](int x) {
+        return x + *pa + *pb + *pc;
+    };
+    assert(allocations() == before);
+    assert(f_ptr(1, 2) == 3 && f_empty(1) == 2 && f_three(1) == 7);
+    std::cout << "小对象内联存储测试通过" << std::endl;
+
+    // 内联对象的拷贝、移动、swap 也不分配
+    before = allocations();
+    mystd::function<int(int)> f_copy = f_three;
+    mystd::function<int(int)> f_moved = std::move(f_three);
+    assert(!f_three);
+    f_copy.swap(f_empty);
+    assert(allocations() == before);
+    assert(f_copy(1) == 2 && f_empty(1) == 7 && f_moved(1) == 7);
+    // 内联对象与堆对象之间 swap
+    f_moved.swap(f_heap_moved);
+    assert(allocations() == before);
+    assert(f_moved(5) == expected && f_heap_moved(1) == 7);
+    std::cout << "内联对象拷贝/移动/swap测试通过" << std::endl;
+
+    static_assert(sizeof(mystd::function<void()>) ==
+                      MYSTD_FUNCTION_BUFFER_SIZE + 2 * sizeof(void*),
+                  "function = 内联缓冲区 + 调用入口 + 管理函数表指针");
+
+    // 刚好超过缓冲区一个指针的对象退回堆
+    int d = 4;
+    before = allocations();
+    mystd::function<int(int)> f_four = [pa = &a, pb = &b, pc = &c, pd = &d](int x) {
+        return x + *pa + *pb + *pc + *pd;
+    };
+    assert(allocations() == before + 1);
+    assert(f_four(1) == 11);
+
+    // 移动可能抛异常的小对象也退回堆
+    struct ThrowingMove {
+        int value;
+        ThrowingMove(int v) : value(v) {}
+        ThrowingMove(const ThrowingMove& other) : value(other.value) {}
+        ThrowingMove(ThrowingMove&& other) noexcept(false) : value(other.value) {}
+        int operator()(int x) const { return value + x; }
+    };
+    before = allocations();
+    mystd::function<int(int)> f_throwing = ThrowingMove(10);
+    assert(allocations() == before + 1);
+    assert(f_throwing(1) == 11);
+    std::cout << "缓冲区边界测试通过" << std::endl;
 }
 
 // 测试类型转换和兼容性
@@ -207,6 +293,156 @@ void test_type_compatibility() {
     std::cout << "参数隐式转换测试通过" << std::endl;
 }
 
+// 测试只移动的 unique_function
+void test_unique_function() {
+    std::cout << "\n=== 测试unique_function ===" << std::endl;
+
+    // 捕获 unique_ptr 的任务：function 无法存放，unique_function 可以
+    auto buffer = std::make_unique<int>(42);
+    int* raw = buffer.get();
+    auto capture = [p = std::move(buffer)]() { return *p; };
+    static_assert(!std::is_copy_constructible_v<mystd::unique_function<int()>>,
+                  "unique_function 必须只能移动");
+    static_assert(std::is_constructible_v<mystd::unique_function<int()>, decltype(capture)>,
+                  "unique_function 接受只能移动的对象");
+    mystd::unique_function<int()> task = std::move(capture);
+    assert(task() == 42);
+    std::cout << "捕获unique_ptr测试通过" << std::endl;
+
+    // 移动的是同一块缓冲区，没有深拷贝
+    mystd::unique_function<int()> moved = std::move(task);
+    assert(!task);
+    assert(moved() == 42);
+    long before = allocations();
+    mystd::unique_function<int()> moved_again;
+    moved_again = std::move(moved);
+    assert(allocations() == before && !moved);
+    assert(moved_again() == 42 && raw != nullptr);
+    std::cout << "移动语义测试通过" << std::endl;
+
+    // 被整体移动进来的大 vector 不会被拷贝
+    std::vector<int> big(100000, 1);
+    const int* data = big.data();
+    mystd::unique_function<const int*()> owner =
+        [v = std::move(big)]() { return v.data(); };
+    mystd::unique_function<const int*()> owner2 = std::move(owner);
+    assert(owner2() == data);
+    std::cout << "大缓冲区零拷贝测试通过" << std::endl;
+
+    // 只移动的小对象依旧内联存储
+    struct MoveOnly {
+        int value;
+        explicit MoveOnly(int v) : value(v) {}
+        MoveOnly(MoveOnly&&) noexcept = default;
+        MoveOnly(const MoveOnly&) = delete;
+        int operator()(int x) const { return value + x; }
+    };
+    before = allocations();
+    mystd::unique_function<int(int)> small = MoveOnly(5);
+    mystd::unique_function<int(int)> small2 = std::move(small);
+    assert(allocations() == before);
+    assert(small2(1) == 6);
+    std::cout << "只移动小对象内联存储测试通过" << std::endl;
+
+    // 直接接管 function 的对象，不再包一层
+    mystd::function<int(int)> f = [](int x) { return x * 2; };
+    before = allocations();
+    mystd::unique_function<int(int)> from_function = std::move(f);
+    assert(allocations() == before);
+    assert(!f && from_function(4) == 8);
+    mystd::function<int(int)> f2 = Adder(1);
+    mystd::unique_function<int(int)> from_copy = f2;
+    assert(f2(1) == 2 && from_copy(1) == 2);
+    std::cout << "从function构造测试通过" << std::endl;
+
+    // 空对象、nullptr 与 swap
+    mystd::unique_function<int(int)> empty;
+    assert(!empty);
+    bool exception_caught = false;
+    try {
+        empty(1);
+    } catch (const std::bad_function_call&) {
+        exception_caught = true;
+    }
+    assert(exception_caught);
+    mystd::swap(empty, from_function);
+    assert(empty(4) == 8 && !from_function);
+    empty = nullptr;
+    assert(!empty);
+    std::cout << "空对象与swap测试通过" << std::endl;
+}
+
+// 以 function_ref 作为同步回调参数
+int apply_twice(mystd::function_ref<int(int)> f, int x) {
+    return f(f(x));
+}
+
+// 测试不拥有对象的 function_ref
+void test_function_ref() {
+    std::cout << "\n=== 测试function_ref ===" << std::endl;
+    static_assert(sizeof(mystd::function_ref<int(int)>) == 2 * sizeof(void*),
+                  "function_ref 只有两个指针");
+    static_assert(std::is_trivially_copyable_v<mystd::function_ref<int(int)>>,
+                  "function_ref 必须可平凡拷贝");
+
+    long before = allocations();
+
+    // lambda、函数指针、函数对象
+    assert(apply_twice([](int x) { return x + 1; }, 1) == 3);
+    mystd::function_ref<int(int, int)> r_add = add;
+    assert(r_add(2, 3) == 5);
+    int (*fp)(int, int) = add;
+    mystd::function_ref<int(int, int)> r_fp = fp;
+    fp = nullptr; // 保存的是函数指针的值，而不是变量的地址
+    assert(r_fp(2, 3) == 5);
+    Multiplier mult;
+    assert(mystd::function_ref<int(int, int)>(mult)(3, 4) == 12);
+    std::cout << "lambda/函数指针/函数对象测试通过" << std::endl;
+
+    // 引用的是原对象：状态变化对调用方可见
+    int counter = 0;
+    auto inc = [&counter](int x) { return counter += x; };
+    mystd::function_ref<int(int)> r_inc = inc;
+    r_inc(2);
+    r_inc(3);
+    assert(counter == 5);
+    struct Accumulate {
+        int total = 0;
+        int operator()(int x) { return total += x; }
+    } acc;
+    mystd::function_ref<int(int)> r_acc = acc;
+    mystd::function_ref<int(int)> r_acc_copy = r_acc;
+    r_acc(1);
+    r_acc_copy(2);
+    assert(acc.total == 3);
+    std::cout << "引用语义测试通过" << std::endl;
+
+    // 从 function / unique_function 构造，直接借用其存储
+    mystd::function<int(int)> f = Adder(10);
+    mystd::function_ref<int(int)> r_f = f;
+    assert(r_f(1) == 11 && apply_twice(f, 1) == 21);
+    mystd::unique_function<int(int)> uf = [](int x) { return x * 3; };
+    assert(apply_twice(uf, 1) == 9);
+    mystd::function<int(int)> empty;
+    mystd::function_ref<int(int)> r_empty = empty;
+    bool exception_caught = false;
+    try {
+        r_empty(1);
+    } catch (const std::bad_function_call&) {
+        exception_caught = true;
+    }
+    assert(exception_caught);
+    std::cout << "从function构造测试通过" << std::endl;
+
+    // void 返回与参数转换
+    mystd::function_ref<void(long)> r_void = inc;
+    r_void(5L);
+    assert(counter == 10);
+
+    assert(allocations() == before);
+    std::cout << "零分配测试通过" << std::endl;
+}
+
 int main() {
     std::cout << "开始测试mystd::function实现...\n" << std::endl;
     
@@ -216,6 +452,8 @@ int main() {
     test_swap();
     test_large_callables();
     test_type_compatibility();
+    test_unique_function();
+    test_function_ref();
     
     std::cout << "\n所有测试通过！" << std::endl;
     return 0;
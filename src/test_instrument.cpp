@@ -0,0 +1,109 @@
+// Tests for the opt-in per-type instrumentation (include/instrument.hpp).
+#define SMART_PTR_INSTRUMENT
+#include <cassert>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "control_.hpp"
+
+struct Tracked {
+  int value = 0;
+};
+struct Broadcast {
+  int value = 0;
+};
+struct Big {
+  char data[128] = {};
+  int operator()() const { return data[0]; }
+};
+
+void report(const std::string& name, bool passed) {
+  std::cout << "  " << name << ": " << (passed ? "PASSED" : "FAILED")
+            << std::endl;
+  assert(passed);
+}
+
+int main() {
+  std::cout << "Starting instrumentation tests..." << std::endl;
+
+  {
+    auto a = ::make_shared<Tracked>();
+    SharedPtr<Tracked> b(new Tracked);
+    {
+      SharedPtr<Tracked> c = a;
+      SharedPtr<Tracked> d = b;
+    }
+    WeakPtr<Tracked> weak(a);
+    bool locked = static_cast<bool>(weak.lock());
+    a = nullptr;
+    bool expired = !weak.lock();
+    instrument_type_stats s = instrument::stats<Tracked>();
+    report("allocations, copies and lock outcomes",
+           locked && expired && s.block_allocations == 2 &&
+               s.objects_created == 2 && s.objects_destroyed == 1 &&
+               s.live == 1 && s.peak_live == 2 && s.copies == 2 &&
+               s.lock_successes == 1 && s.lock_failures == 1 &&
+               s.lock_success_rate() == 0.5);
+  }
+
+  {
+    // Counters from threads that have exited are kept.
+    std::vector<std::thread> threads;
+    SharedPtr<const Tracked> shared = ::make_shared<Tracked>();
+    for (int t = 0; t < 4; ++t) {
+      threads.emplace_back([shared]() {
+        for (int i = 0; i < 1000; ++i) {
+          SharedPtr<const Tracked> copy = shared;
+        }
+      });
+    }
+    for (auto& t : threads) {
+      t.join();
+    }
+    instrument_type_stats s = instrument::stats<Tracked>();
+    report("per-thread counters are aggregated",
+           s.copies == 2 + 4 + 4 * 1000 && s.peak_live == 2);
+  }
+
+  {
+    // Merged bulk operations still count every copy and release.
+    SharedPtr<Broadcast> source = ::make_shared<Broadcast>();
+    std::vector<SharedPtr<Broadcast>> copies(16);
+    source.share_n(copies.begin(), copies.size());
+    std::uint64_t released = instrument::stats<Broadcast>().releases;
+    release_range(copies.begin(), copies.end());
+    instrument_type_stats s = instrument::stats<Broadcast>();
+    report("share_n and release_range are counted",
+           s.copies == 16 && s.releases - released == 16 &&
+               source.use_count() == 1);
+  }
+
+  {
+    mystd::function<int()> small([] { return 1; });
+    mystd::function<int()> big{Big()};
+    mystd::function<int()> big_copy = big;
+    instrument_type_stats s = instrument::stats<Big>();
+    report("mystd::function inline vs heap storage",
+           s.function_heap == 2 && s.function_inline == 0 && big_copy() == 0 &&
+               small() == 1);
+  }
+
+  {
+    std::ostringstream table, json;
+    instrument::dump_table(table);
+    instrument::dump_json(json);
+    std::string j = json.str();
+    report("table and JSON dumps",
+           table.str().find("Tracked") != std::string::npos &&
+               j.rfind("{\"types\":[", 0) == 0 && j.back() == '}' &&
+               j.find("\"name\":\"Tracked\"") != std::string::npos &&
+               j.find("\"lock_failures\":1") != std::string::npos);
+    std::cout << table.str();
+  }
+
+  std::cout << "All instrumentation tests passed." << std::endl;
+  return 0;
+}
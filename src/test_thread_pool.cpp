@@ -0,0 +1,123 @@
+// Tests for the work-stealing thread pool (include/thread_pool.hpp).
+#include <atomic>
+#include <cassert>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "thread_pool.hpp"
+
+void report(const std::string& name, bool passed) {
+  std::cout << "  " << name << ": " << (passed ? "PASSED" : "FAILED")
+            << std::endl;
+  assert(passed);
+}
+
+// Fork-join sum of [first, last): each level submits one half and waits for
+// it from inside a worker, which must not deadlock even with two threads.
+long parallel_sum(thread_pool& pool, long first, long last) {
+  if (last - first <= 1000) {
+    long sum = 0;
+    for (long i = first; i < last; ++i) sum += i;
+    return sum;
+  }
+  long middle = first + (last - first) / 2;
+  task_future<long> left =
+      pool.submit([&pool, first, middle] { return parallel_sum(pool, first, middle); });
+  long right = parallel_sum(pool, middle, last);
+  return left.get() + right;
+}
+
+int main() {
+  std::cout << "Starting thread pool tests..." << std::endl;
+
+  {
+    thread_pool pool(4);
+    task_future<int> answer = pool.submit([] { return 42; });
+    task_future<int> copy = answer;
+    task_future<void> failing =
+        pool.submit([] { throw std::runtime_error("boom"); });
+    bool threw = false;
+    try {
+      failing.get();
+    } catch (const std::runtime_error&) {
+      threw = true;
+    }
+    report("futures carry values and exceptions",
+           answer.get() == 42 && copy.get() == 42 && copy.ready() && threw);
+  }
+
+  {
+    // Move-only captures go straight into unique_function.
+    thread_pool pool(2);
+    auto owned = std::make_unique<int>(7);
+    task_future<int> result =
+        pool.submit([p = std::move(owned)] { return *p * 6; });
+    report("move-only tasks", result.get() == 42);
+  }
+
+  {
+    // Several outside threads submitting, every task runs exactly once.
+    std::atomic<long> sum(0);
+    {
+      thread_pool pool(4);
+      std::vector<std::thread> producers;
+      for (int t = 0; t < 4; ++t) {
+        producers.emplace_back([&pool, &sum, t] {
+          for (int i = 0; i < 10000; ++i) {
+            pool.post([&sum, t, i] { sum.fetch_add(t * 10000 + i); });
+          }
+        });
+      }
+      for (auto& t : producers) t.join();
+    }  // The destructor drains everything that was posted.
+    long n = 40000;
+    report("concurrent posts all run once", sum.load() == n * (n - 1) / 2);
+  }
+
+  {
+    thread_pool pool(2);
+    long expected = 1000000L * (1000000L - 1) / 2;
+    task_future<long> total =
+        pool.submit([&pool] { return parallel_sum(pool, 0, 1000000); });
+    report("nested waits inside workers help instead of blocking",
+           total.get() == expected);
+  }
+
+  {
+    std::atomic<int> count(0);
+    {
+      thread_pool pool(3);
+      std::vector<mystd::unique_function<void()>> batch;
+      for (int i = 0; i < 1000; ++i) {
+        batch.emplace_back([&count] { count.fetch_add(1); });
+      }
+      pool.post_batch(batch.begin(), batch.end());
+      // Tasks posted from inside a task go to that worker's own deque.
+      pool.post([&pool, &count] {
+        for (int i = 0; i < 1000; ++i) {
+          pool.post([&count] { count.fetch_add(1); });
+        }
+      });
+    }
+    report("post_batch and posts from workers", count.load() == 2000);
+  }
+
+  {
+    // Owner pops from the bottom, thieves take from the top.
+    chase_lev_deque<int*> deque(2);
+    int values[100];
+    for (int& v : values) deque.push(&v);
+    bool passed = deque.pop() == &values[99] && deque.steal() == &values[0];
+    int remaining = 0;
+    while (deque.pop()) ++remaining;
+    report("chase_lev_deque grows and orders both ends",
+           passed && remaining == 98 && deque.empty() && !deque.steal());
+  }
+
+  std::cout << "All thread pool tests passed." << std::endl;
+  return 0;
+}
@@ -0,0 +1,174 @@
+// Tests for unique_ptr, unique_ptr<T[]> and make_unique (unique_ptr.hpp).
+#include <cassert>
+#include <iostream>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "unique_ptr.hpp"
+
+struct Counted {
+  static int constructed;
+  static int destroyed;
+  int value = 0;
+  Counted() { ++constructed; }
+  ~Counted() { ++destroyed; }
+};
+int Counted::constructed = 0;
+int Counted::destroyed = 0;
+
+// A deleter with state: it records how many objects it deleted and under
+// which tag, so a test can tell which deleter instance ran.
+struct TaggedDeleter {
+  int tag = 0;
+  int* deleted = nullptr;
+  void operator()(int* p) const {
+    ++*deleted;
+    delete p;
+  }
+};
+struct TaggedArrayDeleter {
+  int* deleted = nullptr;
+  void operator()(int* p) const {
+    ++*deleted;
+    delete[] p;
+  }
+};
+struct EmptyDeleter {
+  void operator()(int* p) const { delete p; }
+};
+
+// Its destructor looks at the unique_ptr that owned it.
+struct Observer;
+unique_ptr<Observer>* observed_owner = nullptr;
+struct Observer {
+  bool* done;
+  explicit Observer(bool* d) : done(d) {}
+  ~Observer() {
+    *done = true;
+    seen = observed_owner->get();
+  }
+  static Observer* seen;
+};
+Observer* Observer::seen = nullptr;
+
+void report(const std::string& name, bool passed) {
+  std::cout << "  " << name << ": " << (passed ? "PASSED" : "FAILED")
+            << std::endl;
+  assert(passed);
+}
+
+int main() {
+  std::cout << "Starting unique_ptr tests..." << std::endl;
+
+  {
+    Counted::constructed = Counted::destroyed = 0;
+    {
+      unique_ptr<Counted[]> raw(new Counted[3]);
+      unique_ptr<Counted[]> made = make_unique<Counted[]>(4);
+      made[1].value = 5;
+      raw[2].value = made[1].value + 1;
+      report("operator[] reads and writes elements",
+             raw[2].value == 6 && made.get()[1].value == 5 &&
+                 made[0].value == 0);
+    }
+    report("unique_ptr<T[]> runs delete[] for every element",
+           Counted::constructed == 7 && Counted::destroyed == 7);
+  }
+
+  {
+    unique_ptr<int[]> zeros = make_unique<int[]>(5);
+    bool all_zero = true;
+    for (int i = 0; i < 5; ++i) all_zero = all_zero && zeros[i] == 0;
+    zeros.reset(new int[2]{3, 4});
+    report("make_unique<T[]> value-initializes, reset replaces the array",
+           all_zero && zeros[0] == 3 && zeros[1] == 4);
+  }
+
+  {
+    Counted::constructed = Counted::destroyed = 0;
+    unique_ptr<Counted[]> a = make_unique<Counted[]>(2);
+    Counted* first = a.get();
+    unique_ptr<Counted[]> b(std::move(a));
+    unique_ptr<Counted[]> c;
+    c = std::move(b);
+    bool passed = !a && !b && c.get() == first && Counted::destroyed == 0;
+    c = nullptr;
+    passed = passed && !c && Counted::destroyed == 2;
+    static_assert(std::is_same<unique_ptr<int[]>::deleter_type,
+                               std::default_delete<int[]>>::value,
+                  "unique_ptr<T[]> deletes with delete[] by default");
+    report("unique_ptr<T[]> moves and resets like unique_ptr<T>", passed);
+  }
+
+  {
+    bool done = false;
+    unique_ptr<Observer> owner(new Observer(&done));
+    observed_owner = &owner;
+    Observer* replacement = new Observer(&done);
+    owner.reset(replacement);
+    bool passed = done && Observer::seen == replacement;
+    done = false;
+    owner = nullptr;
+    passed = passed && done && Observer::seen == nullptr;
+    observed_owner = nullptr;
+    report("reset installs the new pointer before deleting the old one",
+           passed);
+  }
+
+  {
+    static_assert(noexcept(std::declval<unique_ptr<int>&>().reset()),
+                  "reset must be noexcept");
+    static_assert(noexcept(std::declval<unique_ptr<int[]>&>().reset()),
+                  "array reset must be noexcept");
+    static_assert(noexcept(std::declval<unique_ptr<int>&>().swap(
+                      std::declval<unique_ptr<int>&>())),
+                  "swap must be noexcept");
+    static_assert(noexcept(swap(std::declval<unique_ptr<int>&>(),
+                                std::declval<unique_ptr<int>&>())),
+                  "free swap must be noexcept");
+    auto lambda = [](int* p) { delete p; };
+    bool passed =
+        sizeof(unique_ptr<int>) == sizeof(int*) &&
+        sizeof(unique_ptr<int[]>) == sizeof(int*) &&
+        sizeof(unique_ptr<int, EmptyDeleter>) == sizeof(int*) &&
+        sizeof(unique_ptr<int, decltype(lambda)>) == sizeof(int*) &&
+        sizeof(unique_ptr<int, TaggedDeleter>) ==
+            sizeof(int*) + sizeof(TaggedDeleter) &&
+        sizeof(unique_ptr<int[], TaggedArrayDeleter>) ==
+            sizeof(int*) + sizeof(TaggedArrayDeleter);
+    report("stateless deleters take no space, stateful ones are stored",
+           passed);
+  }
+
+  {
+    int deleted_a = 0;
+    int deleted_b = 0;
+    {
+      unique_ptr<int, TaggedDeleter> a(new int(1),
+                                       TaggedDeleter{1, &deleted_a});
+      unique_ptr<int, TaggedDeleter> b(new int(2),
+                                       TaggedDeleter{2, &deleted_b});
+      a.swap(b);
+      bool swapped = *a == 2 && a.get_deleter().tag == 2 && *b == 1 &&
+                     b.get_deleter().tag == 1;
+      a.reset();
+      swapped = swapped && deleted_b == 1 && deleted_a == 0;
+      a = std::move(b);
+      swapped = swapped && *a == 1 && a.get_deleter().tag == 1 && !b &&
+                deleted_a == 0;
+      report("swap and move carry the stateful deleter", swapped);
+    }
+    int deleted_array = 0;
+    {
+      unique_ptr<int[], TaggedArrayDeleter> array(
+          new int[3]{}, TaggedArrayDeleter{&deleted_array});
+      array[2] = 9;
+    }
+    report("stateful deleters run exactly once",
+           deleted_a == 1 && deleted_b == 1 && deleted_array == 1);
+  }
+
+  std::cout << "All unique_ptr tests passed." << std::endl;
+  return 0;
+}